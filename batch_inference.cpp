@@ -81,12 +81,7 @@ InferenceStats process_frame(
         // Inference
         Timer inference_timer;
         PythonInference inference(onnx_model);
-        auto inference_output = inference.run(
-            voxel_data.voxels,
-            voxel_data.coordinates,
-            voxel_data.num_points,
-            voxel_data.num_voxels
-        );
+        auto inference_output = inference.run(voxel_data, voxel_config);
         stats.inference_time = inference_timer.elapsed();
         
         // Post-process
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "rpn_backend.h"
+
+// CPU 替身 RPN：固定随机权重的 1x1 卷积 head（64 -> box + score [+ dir] 通道）
+// 没有 NPU 时用来跑通整条流水线、做性能基准，输出没有检测意义
+struct CpuRPNConfig {
+    int in_channels = 64;
+    int grid_h = 496;
+    int grid_w = 432;
+    int box_channels = 42;     // num_anchors * 7
+    int score_channels = 18;   // num_anchors * num_classes
+    int dir_channels = 0;      // num_anchors * num_dir_bins，0 表示不输出方向 head
+    int max_batch = 8;
+    uint32_t seed = 42;
+    float score_bias = -6.0f;  // 空 cell 的 score logit，保证空地不出框
+    float simulated_latency_ms = 0.0f;  // 每次推理额外 sleep，模拟 NPU 耗时
+};
+
+class CpuRPN : public RPNBackend {
+public:
+    explicit CpuRPN(const CpuRPNConfig& config = CpuRPNConfig());
+
+    void run(
+        const float* rpn_input_map,
+        float* box_map,
+        float* score_map,
+        int batch_size) override;
+
+    // 1x1 卷积在空 cell 上的输出就是 bias：整张输出填 bias 后只对被占用的 cell 计算，
+    // 直接消费稀疏输入，不需要稠密回退
+    void run_sparse(
+        const SparsePillars& pillars,
+        float* box_map,
+        float* score_map) override;
+
+    int max_batch() const override { return config_.max_batch; }
+    const float* dir_map() const override { return dir_map_.empty() ? nullptr : dir_map_.data(); }
+
+private:
+    CpuRPNConfig config_;
+    std::vector<float> weights_;  // [out_channels, in_channels]，先 box 再 score 最后 dir
+    std::vector<float> bias_;     // [out_channels]
+    std::vector<float> dir_map_;  // [max_batch, dir_channels, H, W]
+
+    int out_channels() const { return config_.box_channels + config_.score_channels + config_.dir_channels; }
+    // 输出通道 o 在第 b 帧的 [H, W] 平面
+    float* output_plane(int o, size_t b, float* box_map, float* score_map);
+    void fill_bias(float* box_map, float* score_map, int batch_size);
+    void simulate_latency() const;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "pipeline.h"
+
+// 多实例引擎池：N 个互相独立的 Pipeline（各自的工作区、RPN 后端/Context），
+// 每个实例一个工作线程，可以绑定到指定 CPU 核或 NUMA 节点。
+// submit() 默认按传感器 id 把帧路由到固定实例，同一传感器的帧按提交顺序处理；
+// 关闭 sensor_affinity 后每帧发给当前负载最小的实例，单个传感器的帧也能并发处理。
+struct EnginePoolConfig {
+    int num_instances = 1;
+    
+    // 每个实例绑定的 CPU 核列表（下标 = 实例号），为空或缺省则不绑定
+    std::vector<std::vector<int>> instance_cpus;
+    // 每个实例绑定的 NUMA 节点（下标 = 实例号，-1 不绑定），只在 instance_cpus 未指定时生效
+    std::vector<int> instance_numa_nodes;
+    
+    // 每个实例的待处理帧上限
+    size_t queue_capacity = 4;
+    // 队列满时: true = 直接丢帧（future 抛异常），false = submit 阻塞等待
+    bool drop_when_full = false;
+    
+    // true: 按传感器固定路由，同一传感器的帧串行、按序处理，可以保留每个传感器的状态
+    //       （如时序 pillar 缓存）；只有多个传感器时多个实例才会同时工作。
+    // false: 没有显式路由的传感器每帧发给负载（排队 + 正在处理）最小的实例，
+    //        同一传感器的帧可能并发处理、乱序完成（各自的 future 不受影响）
+    bool sensor_affinity = true;
+    
+    // 传感器 -> 实例 的显式路由；未列出的传感器按 sensor_id % num_instances（sensor_affinity 时）
+    std::map<int, int> sensor_routes;
+    
+    // 实时调度（deadline_ms > 0 时启用）：每帧的截止时间 = 提交时间 + deadline_ms。
+    // 出队时用已等待时间加上该实例最近的处理耗时估计来决定：
+    //   来得及完整处理 -> Full；只来得及降级处理 -> Degraded（见 PipelineConfig）；
+    //   都来不及 -> 丢弃，future 抛 FrameExpired
+    double deadline_ms = 0;
+    bool allow_degrade = true;
+    bool drop_expired = true;
+};
+
+// 帧在出队时已经赶不上截止时间而被丢弃
+class FrameExpired : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// 单个实例的吞吐统计（从池创建开始累计）
+struct InstanceStats {
+    int instance = 0;
+    uint64_t frames = 0;          // 完成的帧数
+    uint64_t failed = 0;          // 处理中抛异常的帧数
+    uint64_t dropped = 0;         // 队列满被丢弃的帧数
+    double busy_ms = 0;           // 实际处理耗时累计
+    double mean_latency_ms = 0;   // 提交 -> 完成 的平均延迟（含排队）
+    double max_latency_ms = 0;
+    double fps = 0;               // frames / 运行时间
+    double utilization = 0;       // busy_ms / 运行时间
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    
+    // 实时调度统计（deadline_ms > 0 时有效）
+    uint64_t degraded = 0;        // 以降级模式处理的帧数
+    uint64_t expired = 0;         // 出队时已来不及而丢弃的帧数
+    uint64_t deadline_missed = 0; // 处理完成但超过截止时间的帧数
+    double miss_rate = 0;         // (expired + deadline_missed + dropped) / (frames + expired + dropped)
+};
+
+// 在实例自己的工作线程上调用（线程已绑核），这样 Pipeline 的缓冲区按 first-touch
+// 分配在本地 NUMA 节点上，RPNRunner 的 Context 也绑定在该线程
+using PipelineFactory = std::function<std::unique_ptr<Pipeline>(int instance)>;
+
+class EnginePool {
+public:
+    // 所有实例构造完成后才返回；任一实例构造失败则抛出该异常
+    EnginePool(const EnginePoolConfig& config, PipelineFactory factory);
+    ~EnginePool();
+    
+    EnginePool(const EnginePool&) = delete;
+    EnginePool& operator=(const EnginePool&) = delete;
+    
+    // 提交一帧，返回该帧的检测结果
+    std::future<std::vector<Box3D>> submit(int sensor_id, std::vector<float> points);
+    
+    // 传感器 id 对应的固定实例号；sensor_affinity = false 且没有显式路由时返回 -1（每帧按负载选择）
+    int route(int sensor_id) const;
+    
+    std::vector<InstanceStats> stats() const;
+    int num_instances() const { return static_cast<int>(instances_.size()); }
+    
+    // 处理完已排队的帧后停止所有工作线程（析构时自动调用）
+    void shutdown();
+    
+private:
+    struct Instance;
+    
+    void worker_loop(Instance& inst, const PipelineFactory& factory,
+                     std::promise<void>& ready);
+    
+    // 排队 + 正在处理的帧数最少的实例；平局时从轮转位置开始找，避免总是落到实例 0
+    Instance& least_loaded();
+    
+    EnginePoolConfig config_;
+    std::vector<std::unique_ptr<Instance>> instances_;
+    std::atomic<unsigned> next_instance_{0};
+};
+
+// 解析 NUMA 节点的 CPU 列表（/sys/devices/system/node/node<N>/cpulist，如 "0-7,16-23"）
+std::vector<int> numa_node_cpus(int node);
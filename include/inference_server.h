@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "engine_pool.h"
+
+// 常驻推理服务：在 Unix domain socket 上接收点云帧（协议见 server_protocol.h），
+// 交给 EnginePool 并发处理，按请求顺序返回二进制检测结果（实例可能乱序完成，回复仍按序）。
+// 单个 sensor_id 的帧能否在多个实例上并发取决于 EnginePoolConfig::sensor_affinity。
+// 模型加载 / Context 创建只在启动时做一次。
+struct ServerConfig {
+    std::string socket_path = "/tmp/pointpillars.sock";
+    int num_point_features = 4;        // 帧的每点 float 数，必须与 Pipeline 配置一致
+    int max_clients = 16;
+    size_t max_inflight_per_client = 8; // 单连接未返回的帧数上限（超过则暂停读取）
+    size_t latency_window = 4096;       // 延迟分位数统计的滑动窗口大小
+};
+
+class InferenceServer {
+public:
+    InferenceServer(const ServerConfig& config, EnginePool& pool);
+    ~InferenceServer();
+    
+    // 监听并服务，阻塞直到 stop()
+    void run();
+    
+    // 请求停止；只写一个原子标志，可以在信号处理函数里调用
+    void stop() { stopping_ = true; }
+    
+    // 健康/延迟统计（JSON 文本）
+    std::string stats_json() const;
+    
+private:
+    void serve_client(int fd, uint64_t id);
+    // join 已经结束的连接线程，避免长时间运行时线程对象无限累积
+    void reap_finished_clients();
+    void record_frame(double latency_ms, bool ok);
+    
+    ServerConfig config_;
+    EnginePool& pool_;
+    std::atomic<bool> stopping_{false};
+    int listen_fd_ = -1;
+    std::chrono::steady_clock::time_point started_;
+    
+    // 连接管理
+    mutable std::mutex clients_mutex_;
+    std::set<int> client_fds_;
+    std::map<uint64_t, std::thread> client_threads_;  // 连接序号 -> 服务线程
+    std::vector<uint64_t> finished_clients_;          // 已退出、等待 join 的连接序号
+    uint64_t total_connections_ = 0;
+    
+    // 统计（接收 -> 发送 的端到端延迟）
+    mutable std::mutex stats_mutex_;
+    uint64_t frames_received_ = 0;
+    uint64_t frames_ok_ = 0;
+    uint64_t frames_failed_ = 0;
+    uint64_t protocol_errors_ = 0;
+    std::vector<double> latency_window_;
+    size_t latency_next_ = 0;
+    double latency_max_ms_ = 0;
+};
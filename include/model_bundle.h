@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "pfn.hpp"
+#include "postprocess.h"
+#include "voxelizer.h"
+
+// 模型包：一个带版本号的文件，包含 PFN 预打包权重（内核布局）、体素 / anchor / decode 配置
+// 和 RPN 模型路径，取代 pfn_weight.bin + pfn_bias.bin + 代码里的默认配置。
+// 以只读 mmap 打开：多个引擎进程共享同一份物理页，启动时不解析、不重排权重。
+//
+// 文件布局（小端）：
+//   [BundleHeader 64B][BundleSectionEntry * num_sections][各段，起始偏移 64 字节对齐]
+// checksum 为 header 之后全部字节的 FNV-1a 64
+constexpr char kBundleMagic[8] = {'P', 'P', 'B', 'U', 'N', 'D', 'L', 'E'};
+constexpr uint32_t kBundleVersion = 1;
+constexpr size_t kBundleAlignment = 64;
+
+enum class BundleSection : uint32_t {
+    PfnMeta = 1,          // BundlePfnMeta
+    PfnPointWeights = 2,  // float [F, C]
+    PfnAugWeights = 3,    // float [6, C]
+    PfnBias = 4,          // float [C]
+    Voxel = 5,            // BundleVoxelConfig
+    Decode = 6,           // BundleDecodeConfig
+    Anchors = 7,          // float [num_anchor_sizes, 4] (w, l, h, z_center)，后接 float [num_rotations]
+    RpnModelPath = 8,     // UTF-8 路径，不含结尾 0；相对路径按模型包所在目录解析
+};
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t file_size;
+    uint64_t checksum;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(BundleHeader) == 64, "BundleHeader must be 64 bytes");
+
+struct BundleSectionEntry {
+    uint32_t id;        // BundleSection
+    uint32_t reserved;
+    uint64_t offset;    // 从文件开头算起
+    uint64_t size;      // 字节数
+};
+static_assert(sizeof(BundleSectionEntry) == 24, "BundleSectionEntry must be 24 bytes");
+
+struct BundlePfnMeta {
+    int32_t num_features;
+    int32_t channels;
+    int32_t center_dims;
+    int32_t relu;
+};
+
+// 只保存模型相关的几何；采样 / 预算 / 输出顺序等运行期策略仍由 VoxelConfig 默认值或命令行决定
+struct BundleVoxelConfig {
+    int32_t num_point_features;
+    int32_t max_num_points;
+    int32_t max_voxels;
+    int32_t reserved;
+    float point_cloud_range[6];
+    float voxel_size[3];
+    float reserved2;
+};
+
+struct BundleDecodeConfig {
+    int32_t grid_x;
+    int32_t grid_y;
+    int32_t num_rot;
+    int32_t num_classes;
+    int32_t box_code_size;
+    int32_t num_dir_bins;
+    int32_t num_anchor_sizes;
+    int32_t num_rotations;      // 0 表示按 k * pi / num_rot 均分
+    float voxel_size_x;
+    float voxel_size_y;
+    float x_min;
+    float y_min;
+    float dir_offset;
+    float dir_limit_offset;
+};
+
+// 打包工具的输入
+struct ModelBundleContents {
+    PackedPFNWeights pfn;       // 通常由 PFN_CPU::packed_weights(F) 得到（BN 已折叠）
+    VoxelConfig voxel;
+    DecodeConfig decode;
+    std::string rpn_model_path; // 可为空
+};
+
+// 写出模型包，失败时抛异常
+void write_model_bundle(const std::string& path, const ModelBundleContents& contents);
+
+class ModelBundle {
+public:
+    // 打开并校验 header / 段表；verify_checksum 会读一遍所有页
+    explicit ModelBundle(const std::string& path, bool verify_checksum = true);
+
+    uint32_t version() const { return version_; }
+    const std::string& path() const { return path_; }
+
+    // 指向映射的权重，PFN_CPU::use_packed_weights 直接使用；owner 保持映射存活
+    PackedPFNWeights pfn_weights() const;
+    // 覆盖 base 中的模型几何字段，其余（采样、预算、verbose 等）保留
+    VoxelConfig voxel_config(VoxelConfig base = VoxelConfig()) const;
+    DecodeConfig decode_config(DecodeConfig base = DecodeConfig()) const;
+    // 没有 RPN 段时返回空串
+    std::string rpn_model_path() const;
+
+private:
+    struct Mapping;
+    std::shared_ptr<const Mapping> mapping_;
+    std::string path_;
+    uint32_t version_ = 0;
+
+    // 找不到时返回 nullptr；size 不为 0 时要求段大小一致
+    const uint8_t* section(BundleSection id, size_t* size_out = nullptr) const;
+    const uint8_t* require(BundleSection id, size_t expected_size) const;
+};
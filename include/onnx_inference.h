@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 
+#include "voxelizer.h"
+
 struct InferenceOutput {
     std::vector<float> bboxes;      // [batch, num_det, 7]
     std::vector<float> scores;      // [batch, num_det, num_classes]
@@ -15,19 +17,15 @@ class PythonInference {
 public:
     PythonInference(const std::string& model_path);
     
-    InferenceOutput run(
-        const std::vector<float>& voxels,
-        const std::vector<int>& coordinates,
-        const std::vector<int>& num_points,
-        int num_voxels
-    );
+    // Passes the compact VoxelData planes to inference_service.py as-is
+    InferenceOutput run(const VoxelData& voxel_data, const VoxelConfig& config);
     
 private:
     std::string model_path_;
     
     std::string get_script_dir() const;
-    std::string write_temp_file(const std::string& prefix, const std::vector<float>& data);
-    std::string write_temp_file(const std::string& prefix, const std::vector<int>& data);
+    template <typename T>
+    std::string write_temp_file(const std::string& prefix, const std::vector<T>& data);
 };
 
 #endif // ONNX_INFERENCE_H
@@ -1,33 +1,259 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <vector>
 #include <cstring>
 
-// PFN 输入：VoxelData（来自 Voxelizer）
+#include "roi_mask.h"
+#include "voxelizer.h"
+
+// PFN 输入：VoxelData（来自 Voxelizer）的紧凑 SoA 平面，直接引用不做转换
 // 输出：每个 voxel 的 64 维特征，然后 scatter 到 BEV grid
 struct VoxelInfo {
-    const float* voxels;        // [num_voxels, max_points, 4]
-    const int* coordinates;     // [num_voxels, 4] (batch, z, y, x)
-    const int* num_points;       // [num_voxels]
+    const float* voxels;        // [num_voxels, max_points, num_features]
+    const uint16_t* coor_x;     // [num_voxels] BEV 列
+    const uint16_t* coor_y;     // [num_voxels] BEV 行
+    const uint8_t* batch_ids;   // [num_voxels]，nullptr 表示全部属于第 0 帧
+    const uint8_t* num_points;  // [num_voxels]
     int num_voxels;
     int max_points;             // 通常是 32
+    int num_features = 4;       // 每点原始特征数：4 (x, y, z, intensity)，多帧累积时为 5 (+ 时间差)
+    int batch_size = 1;         // batch id 的取值范围 [0, batch_size)
+};
+
+// 引用 VoxelData 的各平面（voxel_data 须比返回值活得久）
+inline VoxelInfo make_voxel_info(const VoxelData& voxel_data, const VoxelConfig& config, int batch_size = 1) {
+    VoxelInfo info;
+    info.voxels = voxel_data.voxels.data();
+    info.coor_x = voxel_data.coor_x.data();
+    info.coor_y = voxel_data.coor_y.data();
+    info.batch_ids = voxel_data.batch_ids.data();
+    info.num_points = voxel_data.num_points.data();
+    info.num_voxels = voxel_data.num_voxels;
+    info.max_points = config.max_num_points;
+    info.num_features = config.num_point_features;
+    info.batch_size = batch_size;
+    return info;
+}
+
+// 稀疏 BEV 表示：只保存被占用的 pillar，不展开成 [1, 64, 496, 432]
+// KITTI 场景下通常 <10% 的 cell 被占用，稀疏表示比稠密 map 小一个数量级
+struct SparsePillars {
+    std::vector<float> features;        // [P, channels]，每个 pillar 一行
+    std::vector<int32_t> cell_indices;  // [P]，(batch * grid_h + y) * grid_w + x
+    int num_pillars = 0;
+    int batch_size = 1;
+    int channels = 64;
+    int grid_h = 496;
+    int grid_w = 432;
+
+    // 时序缓存的增量信息（PFN_CPU 开启缓存时填写，见 scatter_pillar_delta）：
+    // 相对同一缓存 key 的上一帧 base_frame，只有 changed_rows 行的特征变了，removed_cells 消失了
+    uint64_t frame = 0;                  // 本帧的帧号（全局唯一），0 表示没有增量信息
+    uint64_t base_frame = 0;             // 同一 key 上一帧的帧号，0 表示没有上一帧
+    std::vector<int32_t> changed_rows;   // 重新计算的行（包括新出现的 cell）
+    std::vector<int32_t> removed_cells;  // 上一帧有、本帧没有的 cell
+};
+
+// 稀疏 -> 稠密回退：给只接受完整 BEV map 的后端用（如当前的 NPU 模型）
+// prev_cells 非空时，假定 rpn_input_map 中只有这些 cell 非零（上一帧写入的），
+// 只清零它们而不是对整张 55MB 的 map 做 memset
+void scatter_sparse_to_dense(
+    const SparsePillars& sparse,
+    float* rpn_input_map,
+    const std::vector<int32_t>* prev_cells = nullptr);
+
+// 增量 scatter：rpn_input_map 中须正好是 sparse.base_frame 那一帧 scatter 的结果，
+// 只清零 removed_cells、重写 changed_rows，其余 cell 的特征与上一帧相同，不用再写
+void scatter_pillar_delta(const SparsePillars& sparse, float* rpn_input_map);
+
+// 时序 pillar 缓存的命中统计（见 PFN_CPU::enable_cache）
+struct PillarCacheStats {
+    uint64_t lookups = 0;     // 累计查询的 pillar 数
+    uint64_t hits = 0;        // 累计命中（复用上一帧特征）的 pillar 数
+    int last_pillars = 0;     // 最近一帧的 pillar 数
+    int last_changed = 0;     // 最近一帧重新计算的 pillar 数
+    int last_removed = 0;     // 最近一帧消失的 cell 数（增量模式下被清零）
+
+    double hit_rate() const { return lookups ? static_cast<double>(hits) / lookups : 0.0; }
+};
+
+// PFN 内核直接使用的权重布局（增广项已拆开、xyz 行已合并，见 PFN_CPU::pfn_weights）。
+// 来自 ModelBundle 时指针指向只读 mmap，owner 保持映射存活，PFN_CPU 拷贝之间共享
+struct PackedPFNWeights {
+    int num_features = 0;                  // 每点特征数 F
+    int channels = 0;                      // 输出通道数 C
+    int center_dims = 0;                   // 0: 无增广；2 / 3: 中心项维数
+    bool relu = false;                     // max 之后是否 ReLU
+    const float* point_weights = nullptr;  // [F, C] 每点乘的权重
+    const float* aug_weights = nullptr;    // [6, C] 均值 xyz、中心 xyz 的权重
+    const float* bias = nullptr;           // [C]
+    std::shared_ptr<const void> owner;
 };
 
 class PFN_CPU {
 public:
-    std::vector<float> pfn_weights;  // 权重矩阵: [input_dim, 64]
+    // 权重矩阵: [input_dim, 64]，每点输入按 mmdet3d 的特征增广排列：
+    //   input_dim = F + 6: [原始 F 维, xyz - pillar 内点均值, xyz - pillar 中心]
+    //   input_dim = F + 5: 同上但中心只有 xy（原版 PointPillars）
+    //   其它: 只用原始特征，多出的输入维按 0 处理
+    // 线性层对增广特征可以拆开：均值 / 中心项对同一 pillar 是常数，
+    // 所以每点只需乘 F 维（xyz 的权重已合并），max 之后再加 pillar 常数项。
+    // 填充路径（run / run_sparse / run_incremental）同训练时的网络：点数不足 max_points 的 pillar
+    // 有全 0 的填充行，线性层对它输出偏置，所以 max 结果为 max(真实点的 max + 常数项, bias)；
+    // 动态体素化路径没有填充行，只对真实点取 max
+    std::vector<float> pfn_weights;
     std::vector<float> pfn_bias;     // 偏置: [64]
+    // max 之后是否做 ReLU。ReLU 单调，relu(max_p(x_p)) == max_p(relu(x_p))，
+    // 所以每个 pillar 只做一次；fold_batchnorm 会打开它
+    bool relu = false;
+    int grid_w = 432;                // BEV 网格（与 RPN 输入一致）
+    int grid_h = 496;
+    // 体素几何：增广用的 pillar 中心、run_dynamic 的点 -> cell 映射和 max_voxels 上限。
+    // Pipeline 会设成自己的 VoxelConfig；pillar 假定 z 方向只有一层
+    VoxelConfig voxel;
+    // BEV 感兴趣区域（网格须与 grid_w / grid_h 一致），ROI 外的 pillar / 点直接跳过；为空时处理全部
+    std::shared_ptr<const RoiMask> roi;
+
+    // 把 PFN 的 BatchNorm1d（推理模式）折叠进 pfn_weights / pfn_bias，只在加载时做一次：
+    //   scale = gamma / sqrt(var + eps)
+    //   W'[i, o] = W[i, o] * scale[o]，b'[o] = (b[o] - mean[o]) * scale[o] + beta[o]
+    // 各向量长度须等于输出通道数；pfn_bias 为空时按 0 处理（mmdet3d 的 PFN 线性层不带偏置）。
+    // 折叠后 Linear -> BN -> ReLU -> max 与每点逐层计算等价，每点开销与纯线性层相同。
+    // eps 默认同 mmdet3d PFNLayer 的 BN1d。会打开 relu 并 reset_cache()
+    void fold_batchnorm(const std::vector<float>& gamma, const std::vector<float>& beta,
+                        const std::vector<float>& mean, const std::vector<float>& var,
+                        float eps = 1e-3f);
+
+    // 直接使用预打包权重（如 ModelBundle::pfn_weights()），不再读 pfn_weights / pfn_bias，
+    // 也不做每帧的重排。输入的每点特征数必须等于 packed.num_features
+    void use_packed_weights(PackedPFNWeights packed);
+
+    // 按每点特征数 F 打包当前的 pfn_weights / pfn_bias（打包工具用）；
+    // 返回的指针指向内部缓冲区，下一次运行或修改权重前有效
+    PackedPFNWeights packed_weights(int num_features);
 
     // 运行 PFN + Scatter
     // 输入: voxel_data (来自 Voxelizer)
-    // 输出: rpn_input_map [1, 64, 496, 432] NCHW，直接写入
+    // 输出: rpn_input_map [N, 64, 496, 432] NCHW，直接写入
     void run(const VoxelInfo& voxel_data, float* rpn_input_map);
 
+    // 只运行 PFN，输出稀疏表示 [P, 64] 特征 + [P] cell 索引，不做 scatter
+    // scatter 交给后端（或 scatter_sparse_to_dense 回退）
+    void run_sparse(const VoxelInfo& voxel_data, SparsePillars& out);
+
+    // 动态体素化：不生成 [N, max_points, F] 的 VoxelData，每个点直接映射到 BEV cell，
+    // 乘权重后 max 进该 cell 的累加器。frames[b] 的各 span 合起来是第 b 帧（batch id = b）。
+    // 每个 pillar 不限点数；每帧最多 voxel.max_voxels 个 pillar，按点到达顺序保留（FirstArrival）。
+    // 输出与 run_sparse 相同格式。没有填充行，所以只有点数恰好为 max_points 的 pillar
+    // 与填充路径逐位一致，点数更少的 pillar 不和 bias 取 max。
+    // 不支持时序 pillar 缓存
+    void run_dynamic(const std::vector<std::vector<PointSpan>>& frames, SparsePillars& out);
+
+    // 流式动态体素化：单帧的点分多次到达（激光雷达按扇区发来的数据包）。每个点在 add_points
+    // 里就完成 cell 映射、线性变换和 max，max 与点的到达顺序无关，不需要判断 pillar 是否收齐；
+    // end_stream 只剩每个 pillar 的常数项。结果与把同样顺序的点一次交给 run_dynamic 逐位一致。
+    // voxel / roi / 权重在 begin_stream 时读取，之后到 end_stream 之前不要修改
+    void begin_stream();
+    // [num_points, voxel.num_point_features]，调用返回后不再引用
+    void add_points(const float* points, size_t num_points);
+    void end_stream(SparsePillars& out);
+
+    // 时序 pillar 缓存：对每个 cell 的点内容做量化哈希（坐标/强度按 quant_step 取整，
+    // 与点的顺序无关），哈希和上一帧同一 cell 相同时直接复用上一帧的 64 维特征。
+    // 适合静止安装/低速平台，大部分场景不变。复用的特征与重算的差异受 quant_step 约束。
+    // 修改 pfn_weights / pfn_bias 后需要调用 reset_cache()
+    void enable_cache(float quant_step = 0.01f);
+    void disable_cache();
+    void reset_cache();
+    // 统计对所有 key 累计，last_* 为最近一帧
+    const PillarCacheStats& cache_stats() const { return cache_stats_; }
+    // 缓存按 key（传感器 id）分开保存：一个实例轮流处理多个传感器时，每个传感器只和
+    // 自己的上一帧比较，互不覆盖。之后的 run_sparse / run_incremental 使用该 key
+    void set_cache_key(int key) { cache_key_ = key; }
+
+    // 增量模式（需要先 enable_cache）：rpn_input_map 保存上一帧的结果，
+    // map 中正好是当前 key 上一帧的内容时只重写特征变化的 cell、清零消失的 cell，
+    // 其余 cell 原样保留；否则（第一次调用、换了缓冲区或中间处理过别的 key）完整清零 + scatter
+    void run_incremental(const VoxelInfo& voxel_data, float* rpn_input_map);
+
 private:
-    // 单个 voxel 的 PFN 前向：对每个点做线性变换，然后 max pooling
+    SparsePillars scratch_;  // run() 复用的稀疏缓冲区
+
+    // 时序缓存：每个 key 上一帧的 pillar（按 cell 索引查找）
+    struct CacheState {
+        std::vector<int32_t> cell_row;  // [batch * H * W] -> 上一帧的行号，-1 表示不存在
+        std::vector<int32_t> cells;     // [P_prev] 上一帧的 cell
+        std::vector<uint64_t> hashes;   // [P_prev]
+        std::vector<float> features;    // [P_prev, 64]
+        uint64_t frame = 0;             // 上一帧的帧号（SparsePillars::frame），0 表示没有
+    };
+    bool cache_enabled_ = false;
+    float cache_inv_step_ = 100.0f;
+    PillarCacheStats cache_stats_;
+    std::map<int, CacheState> cache_states_;  // key -> 状态
+    int cache_key_ = 0;
+    std::vector<uint64_t> frame_hashes_;    // 当前帧的哈希（scratch）
+    std::vector<char> prev_present_;        // [P_prev] 当前帧是否还有该 cell（scratch）
+    const float* incremental_map_ = nullptr;
+    uint64_t incremental_frame_ = 0;    // incremental_map_ 中内容的帧号
+
+    uint64_t pillar_hash(const float* voxel_points, int num_pts, int num_features) const;
+
+    // prepare_weights 按每点特征数 F 整理出的权重
+    std::vector<float> point_weights_;  // [F, C] 每点乘的权重（xyz 行已并入增广项）
+    std::vector<float> aug_weights_;    // [6, C] 均值 xyz、中心 xyz 的权重，用于 pillar 常数项
+    // 内核读取的权重视图：指向上面两个缓冲区 + pfn_bias，或 use_packed_weights 的外部权重。
+    // 每次运行开始时由 prepare_weights 重新设置，所以 PFN_CPU 拷贝后指针不会悬空
+    PackedPFNWeights packed_;
+    bool external_weights_ = false;
+
+    // 动态体素化的 scratch
+    std::vector<int32_t> dyn_cell_row_;  // [H * W] -> 当前帧的行号，-1 表示还没有点
+    std::vector<float> dyn_sums_;        // [P, 3] pillar 内点的 xyz 和
+    std::vector<int> dyn_counts_;        // [P]
+
+    // 流式状态（begin_stream .. end_stream）
+    bool stream_active_ = false;
+    SparsePillars stream_;               // 累加中的 pillar，end_stream 时与输出交换
+    std::shared_ptr<const RoiMask> stream_roi_;
+
+    // 整理权重并设置 packed_；外部权重时只检查特征数
+    void prepare_weights(int num_features);
+
+    // roi 的网格与 grid_w / grid_h 不一致时抛异常；没有 ROI 时返回 nullptr
+    const RoiMask* checked_roi() const;
+
+    // max 之后加上 pillar 常数项：bias - W_mean·均值 - W_center·中心；padded 时再和填充行的
+    // 输出 bias 取 max，最后按需 ReLU
+    void finish_pillar(const float* xyz_sum, int num_pts, int x, int y, int channels,
+                       bool padded, float* feature) const;
+
+    // run_sparse 的主循环；Dims 为 StaticDims<预设> 时每点特征数 / 输出通道数是编译期常量
+    template <class Dims>
+    void run_sparse_impl(const Dims& dims, const VoxelInfo& voxel_data, SparsePillars& out);
+    template <class Dims>
+    void run_dynamic_impl(const Dims& dims, const std::vector<std::vector<PointSpan>>& frames,
+                          SparsePillars& out);
+    // run_dynamic / 流式共用：清空输出和累加器；把一块点累加进 out（本帧的行从 first 开始）；
+    // 给 first 之后的行加上 pillar 常数项并复位 cell
+    void begin_dynamic(int channels, int batch_size, SparsePillars& out);
+    template <class Dims>
+    void accumulate_dynamic(const Dims& dims, const float* points, size_t num_points, int first,
+                            int32_t batch_base, const RoiMask* roi_mask, SparsePillars& out);
+    void finish_dynamic(int first, int32_t batch_base, SparsePillars& out);
+    void update_cache(CacheState& state, SparsePillars& out);
+
+    // 单个 voxel 的 PFN 前向：每点线性变换后 max pooling，再加 pillar 常数项
+    template <class Dims>
     void process_voxel(
-        const float* voxel_points,  // [max_points, 4]
+        const Dims& dims,
+        const float* voxel_points,  // [max_points, num_features]
         int num_pts,
-        float* output_feature       // [64]
-    );
+        int max_points,             // num_pts < max_points 时有填充行
+        int x, int y,               // BEV cell
+        float* output_feature       // [C]
+    ) const;
 };
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <array>
+
+#include "voxelizer.h"
+#include "postprocess.h"
+
+// 编译期 pillar 配置：网格、通道数、每 pillar 最大点数、anchor 数等作为模板参数，
+// 内层循环用这些常量实例化后，编译器可以完全展开 / 向量化。
+//
+// 各模块（Voxelizer / PFN_CPU / AnchorDecoder）仍然接受运行期配置：
+// 运行期配置与某个预设一致时走对应的特化实例，否则走通用实现（RuntimeDims）。
+template <int GridX, int GridY, int Channels, int MaxPoints, int PointFeatures,
+          int NumAnchorTypes, int NumRot, int NumClasses, int BoxCodeSize = 7>
+struct PillarConfig {
+    static constexpr int grid_x = GridX;
+    static constexpr int grid_y = GridY;
+    static constexpr int channels = Channels;             // PFN 输出通道
+    static constexpr int max_points = MaxPoints;          // 每 pillar 最大点数
+    static constexpr int point_features = PointFeatures;  // 每点原始特征数
+    static constexpr int num_anchor_types = NumAnchorTypes;
+    static constexpr int num_rot = NumRot;
+    static constexpr int num_classes = NumClasses;
+    static constexpr int box_code_size = BoxCodeSize;     // 每个 anchor 的回归通道数
+    static constexpr int num_anchors = NumAnchorTypes * NumRot;
+    static constexpr int box_channels = num_anchors * BoxCodeSize;
+    static constexpr int score_channels = num_anchors * NumClasses;
+    static constexpr int num_dir_bins = 2;                // 方向分类 head（若模型带）每个 anchor 的 bin 数
+    static constexpr int dir_channels = num_anchors * num_dir_bins;
+};
+
+struct AnchorPreset {
+    float w, l, h, z_center;
+};
+
+// KITTI（mmdet3d hv_pointpillars_secfpn_kitti-3d-3class，当前工程使用的模型）
+struct KittiPillars : PillarConfig<432, 496, 64, 32, 4, 3, 2, 3> {
+    static constexpr std::array<float, 6> point_cloud_range = {0.0f, -39.68f, -3.0f, 69.12f, 39.68f, 1.0f};
+    static constexpr std::array<float, 3> voxel_size = {0.16f, 0.16f, 4.0f};
+    static constexpr int max_voxels = 40000;
+    static constexpr std::array<AnchorPreset, 3> anchors = {{
+        {1.6f, 3.9f, 1.56f, -1.78f},   // Car
+        {0.6f, 0.8f, 1.73f, -0.6f},    // Pedestrian
+        {0.6f, 1.76f, 1.73f, -0.6f},   // Cyclist
+    }};
+};
+
+// nuScenes（mmdet3d hv_pointpillars_secfpn_sbn-all_nus-3d 的 anchor 统计）
+// 5 维点（多帧累积带时间差），10 类，每个 anchor 9 个回归通道（7 + 速度 vx, vy，decode 不使用速度）
+// anchor 的尺寸 / z 中心必须与实际训练的模型一致
+struct NuScenesPillars : PillarConfig<400, 400, 64, 64, 5, 10, 2, 10, 9> {
+    static constexpr std::array<float, 6> point_cloud_range = {-50.0f, -50.0f, -5.0f, 50.0f, 50.0f, 3.0f};
+    static constexpr std::array<float, 3> voxel_size = {0.25f, 0.25f, 8.0f};
+    static constexpr int max_voxels = 40000;
+    static constexpr std::array<AnchorPreset, 10> anchors = {{
+        {1.95017717f, 4.60718145f, 1.72270761f, -1.80032795f},   // car
+        {2.45609390f, 6.73778078f, 2.73004906f, -1.74440365f},   // truck
+        {2.73050468f, 6.38352896f, 3.13312415f, -1.74440365f},   // construction_vehicle
+        {2.94046906f, 11.1885991f, 3.47030982f, -1.68526504f},   // bus
+        {2.87427237f, 12.0132069f, 3.81509561f, -1.67339111f},   // trailer
+        {2.49008838f, 0.48578221f, 0.98297065f, -1.61785072f},   // barrier
+        {0.76279481f, 2.10080220f, 1.44739598f, -1.80984986f},   // motorcycle
+        {0.60058911f, 1.68452161f, 1.27192197f, -1.80984986f},   // bicycle
+        {0.66344886f, 0.72564370f, 1.75748069f, -1.76396500f},   // pedestrian
+        {0.39694519f, 0.40359262f, 1.06232151f, -1.76396500f},   // traffic_cone
+    }};
+};
+
+// 由预设生成运行期配置
+template <class Cfg>
+VoxelConfig make_voxel_config() {
+    VoxelConfig c;
+    c.num_point_features = Cfg::point_features;
+    c.max_num_points = Cfg::max_points;
+    c.point_cloud_range = Cfg::point_cloud_range;
+    c.voxel_size = Cfg::voxel_size;
+    c.max_voxels = Cfg::max_voxels;
+    return c;
+}
+
+template <class Cfg>
+DecodeConfig make_decode_config() {
+    DecodeConfig c;
+    c.grid_x = Cfg::grid_x;
+    c.grid_y = Cfg::grid_y;
+    c.voxel_size_x = Cfg::voxel_size[0];
+    c.voxel_size_y = Cfg::voxel_size[1];
+    c.x_min = Cfg::point_cloud_range[0];
+    c.y_min = Cfg::point_cloud_range[1];
+    c.anchor_sizes.clear();
+    for (const auto& a : Cfg::anchors) {
+        c.anchor_sizes.push_back({a.w, a.l, a.h, a.z_center});
+    }
+    c.num_rot = Cfg::num_rot;
+    c.num_classes = Cfg::num_classes;
+    c.box_code_size = Cfg::box_code_size;
+    c.num_dir_bins = Cfg::num_dir_bins;
+    return c;
+}
+
+// -------------------------
+// 内层循环使用的维度访问：StaticDims 全是 constexpr，RuntimeDims 是运行期值。
+// 同一份循环代码写成 template <class Dims>，两种都能实例化。
+// -------------------------
+template <class Cfg>
+struct StaticDims {
+    static constexpr int point_features() { return Cfg::point_features; }
+    static constexpr int max_points() { return Cfg::max_points; }
+    static constexpr int channels() { return Cfg::channels; }
+    static constexpr int num_anchors() { return Cfg::num_anchors; }
+    static constexpr int num_rot() { return Cfg::num_rot; }
+    static constexpr int num_classes() { return Cfg::num_classes; }
+    static constexpr int box_code_size() { return Cfg::box_code_size; }
+};
+
+// 字段为 0 表示该模块不关心（匹配任意预设）
+struct RuntimeDims {
+    int point_features_ = 0;
+    int max_points_ = 0;
+    int channels_ = 0;
+    int num_anchors_ = 0;
+    int num_rot_ = 0;
+    int num_classes_ = 0;
+    int box_code_size_ = 0;
+
+    int point_features() const { return point_features_; }
+    int max_points() const { return max_points_; }
+    int channels() const { return channels_; }
+    int num_anchors() const { return num_anchors_; }
+    int num_rot() const { return num_rot_; }
+    int num_classes() const { return num_classes_; }
+    int box_code_size() const { return box_code_size_; }
+
+    template <class Cfg>
+    bool matches() const {
+        auto eq = [](int v, int c) { return v == 0 || v == c; };
+        return eq(point_features_, Cfg::point_features) && eq(max_points_, Cfg::max_points) &&
+               eq(channels_, Cfg::channels) && eq(num_anchors_, Cfg::num_anchors) &&
+               eq(num_rot_, Cfg::num_rot) && eq(num_classes_, Cfg::num_classes) &&
+               eq(box_code_size_, Cfg::box_code_size);
+    }
+};
+
+// 运行期维度与预设一致时用 StaticDims<预设> 调用 fn，否则用 RuntimeDims 调用（通用回退）
+template <class Fn>
+decltype(auto) dispatch_dims(const RuntimeDims& dims, Fn&& fn) {
+    if (dims.matches<KittiPillars>()) {
+        return fn(StaticDims<KittiPillars>{});
+    }
+    if (dims.matches<NuScenesPillars>()) {
+        return fn(StaticDims<NuScenesPillars>{});
+    }
+    return fn(dims);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "voxelizer.h"
+#include "prefilter.h"
+#include "pfn.hpp"
+#include "rpn_backend.h"
+#include "postprocess.h"
+#include "roi_mask.h"
+
+// 检测 head 类型
+enum class HeadType {
+    Anchor,   // AnchorDecoder + 旋转 NMS
+    Center,   // CenterDecoder：heatmap 峰值 + top-K，没有 NMS
+};
+
+// 整条流水线的配置：预过滤 -> 体素化 -> PFN -> RPN 后端 -> Decode -> NMS
+struct PipelineConfig {
+    VoxelConfig voxel;
+    PrefilterConfig prefilter;   // crop_range 会被设成 voxel.point_cloud_range
+    bool use_prefilter = true;
+    // 动态体素化：点直接流入 PFN（PFN_CPU::run_dynamic），不生成填充的 VoxelData，
+    // 也不截断每个 pillar 的点数，也没有填充行参与 max（见 PFN_CPU::pfn_weights）。
+    // 只支持 VoxelBudget::FirstArrival，不能和 pillar_cache 同时使用
+    bool dynamic_voxelization = false;
+    DecodeConfig decode;         // pillar 网格尺寸也取自这里
+    // Center 时后端输出 box_map = [N, center.code_size, H, W] 回归、score_map = [N, center.num_classes, H, W]
+    // heatmap（H, W 取 center.grid_y / grid_x），不使用 dir_map；max_num 即 top-K
+    HeadType head = HeadType::Anchor;
+    CenterHeadConfig center;
+    float score_thr = 0.3f;
+    float nms_thr = 0.01f;
+    int max_num = 100;
+    int nms_threads = 1;         // 1: 串行 NMS；其它值走并行 NMS（0 = 硬件线程数），结果相同
+    int nms_pre = 0;             // decode 后只把 score 最高的 nms_pre 个候选送进 NMS，0 = 不限
+    int max_batch = 1;           // process_batch 一次最多处理的帧数
+    bool verbose = false;        // 是否打印各阶段的进度日志
+    
+    // 降级模式（实时调度来不及时使用）：更少的 pillar、更高的分数阈值。
+    // 配合 VoxelBudget::NearFirst 时优先保留近处的 pillar
+    int degraded_max_voxels = 12000;
+    float degraded_score_thr = 0.5f;
+    
+    // BEV 感兴趣区域：世界坐标多边形（取并集），按 decode 网格光栅化后用于 PFN 和 decode；
+    // 为空表示整个网格。目前只支持 anchor head
+    std::vector<RoiMask::Polygon> roi_polygons;
+    
+    // 时序 pillar 缓存（静止安装的传感器）：点内容不变的 pillar 复用上一帧的 PFN 特征，
+    // 按 process / begin_frame 的 sensor_id 分开缓存；后端的稠密回退只重写变化的 cell
+    bool pillar_cache = false;
+    float pillar_cache_step = 0.01f;   // 哈希前的量化步长
+};
+
+// 单帧的处理质量
+enum class FrameQuality {
+    Full,
+    Degraded,
+};
+
+// 各阶段耗时 (ms)；process_batch 时是整个 batch 的耗时
+struct StageTimings {
+    double prefilter_ms = 0;
+    double voxel_ms = 0;
+    double pfn_ms = 0;
+    double rpn_ms = 0;
+    double decode_ms = 0;
+    double nms_ms = 0;
+    double total_ms = 0;
+};
+
+// 一个独立的流水线实例：自带体素化器、PFN 权重、RPN 后端和所有中间缓冲区，
+// 不同实例之间不共享可变状态
+class Pipeline {
+public:
+    Pipeline(const PipelineConfig& config, PFN_CPU pfn, std::unique_ptr<RPNBackend> backend);
+
+    // 单帧: points 为 [N, num_point_features]；sensor_id 只用来区分 pillar 缓存
+    std::vector<Box3D> process(const std::vector<float>& points, StageTimings* timings = nullptr,
+                               FrameQuality quality = FrameQuality::Full, int sensor_id = 0);
+
+    // 多帧: 所有帧体素化进同一个张量（batch id = 帧序号），一次后端调用，
+    // decode/NMS 再按帧拆开。frames.size() 不能超过 max_batch
+    std::vector<std::vector<Box3D>> process_batch(
+        const std::vector<std::vector<float>>& frames,
+        StageTimings* timings = nullptr,
+        FrameQuality quality = FrameQuality::Full,
+        int sensor_id = 0);
+
+    // 流式单帧：一帧的点分多次到达（激光雷达按扇区发包）。add_points 对每块做预过滤并立即
+    // 体素化（动态体素化时连 PFN 一起做），不保留调用方的缓冲区；end_frame 之后只剩
+    // PFN（填充路径）、RPN、decode 和 NMS。预过滤的 keep_every 按块各自计数。
+    // end_frame 的 timings 里 prefilter / voxel / pfn 包含各块的累计耗时，
+    // total_ms 只算 end_frame 本身，即最后一个数据包之后的关键路径
+    void begin_frame(FrameQuality quality = FrameQuality::Full, int sensor_id = 0);
+    void add_points(const float* points, size_t num_points);
+    std::vector<Box3D> end_frame(StageTimings* timings = nullptr);
+
+    const PipelineConfig& config() const { return config_; }
+    const PillarCacheStats& pillar_cache_stats() const { return pfn_.cache_stats(); }
+
+private:
+    PipelineConfig config_;
+    Voxelizer voxelizer_;
+    PointPrefilter prefilter_;
+    PFN_CPU pfn_;
+    std::unique_ptr<RPNBackend> backend_;
+    AnchorDecoder decoder_;
+    CenterDecoder center_decoder_;
+    std::shared_ptr<const RoiMask> roi_;  // 没有 ROI 时为空
+
+    // 复用的中间缓冲区
+    SparsePillars pillars_;
+    std::vector<float> box_map_;    // [max_batch, num_anchors * box_code_size, H, W]（center head: code_size）
+    std::vector<float> score_map_;  // [max_batch, num_anchors * num_classes, H, W]（center head: num_classes）
+    size_t box_frame_size_;
+    size_t score_frame_size_;
+    size_t dir_frame_size_;  // 后端带方向 head 时 dir_map() 每帧的元素数
+
+    // 流式状态（begin_frame .. end_frame）
+    bool streaming_ = false;
+    FrameQuality stream_quality_ = FrameQuality::Full;
+    int stream_sensor_ = 0;
+    StageTimings stream_timings_;
+    std::vector<float> stream_chunk_;  // 预过滤后的一块点
+
+    // 4 + 5：后端推理，再按帧 decode + NMS；pillars_ 须已填好
+    std::vector<std::vector<Box3D>> run_heads(int batch_size, float score_thr, StageTimings& t);
+};
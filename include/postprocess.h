@@ -4,6 +4,15 @@
 #include <cstdint>
 #include <vector>
 
+#include "roi_mask.h"
+
+// 旧版 end2end 输出筛选后的结果
+struct DetectionResult {
+    std::vector<std::array<float, 7>> boxes_3d;
+    std::vector<float> scores_3d;
+    std::vector<int> labels_3d;
+};
+
 class PostProcessor {
 public:
     PostProcessor(float score_thr = 0.3f, float nms_thr = 0.01f, int max_num = 100);
@@ -51,27 +60,124 @@ struct DecodeConfig {
         {0.6f, 1.76f, 1.73f, -0.6f},  // Cyclist (Index 2)
     };
     int num_rot = 2; // 0, 1.57
+    // 每个 rotation 的角度；为空时按 k * pi / num_rot 均分（num_rot=2 即 0, 1.57）
+    std::vector<float> rotations;
 
     // head 形状解释：
     // box_map:  [1, num_anchors*7, H, W]，按 NCHW
     // score_map:[1, num_anchors*num_classes, H, W]（per-class）
     // 若你的 score 是 per-anchor 单通道，把 num_classes 设为 1 即可。
     int num_classes = 3;
+
+    // 每个 anchor 的回归通道数：7 = (dx, dy, dz, dw, dl, dh, dr)，
+    // nuScenes 模型为 9（后两个是速度，decode 时忽略）
+    int box_code_size = 7;
+
+    // 可选方向分类 head：dir_map [1, num_anchors*num_dir_bins, H, W]。
+    // 解码同 mmdet3d：rot - dir_offset 先折到 [-limit_offset, 1 - limit_offset) 个周期内
+    // （周期 = 2pi / num_dir_bins），再加上 dir_offset + 周期 * argmax bin。
+    // 不传 dir_map 时 rot 只做回绕，朝向可能差 pi
+    int num_dir_bins = 2;
+    float dir_offset = 0.0f;
+    float dir_limit_offset = 0.0f;
+
+    bool verbose = true;  // 打印 decode 进度
+};
+
+// 构造时预计算的 anchor 表（SoA）：中心按行/列分开存，其余按 anchor 存
+struct AnchorTable {
+    std::vector<float> center_x;   // [grid_x] 第 x 列 anchor 中心
+    std::vector<float> center_y;   // [grid_y] 第 y 行 anchor 中心
+    std::vector<float> w, l, h;    // [num_anchors]
+    std::vector<float> z;          // [num_anchors] z 中心
+    std::vector<float> rot;        // [num_anchors] 基准角度
+    std::vector<float> diagonal;   // [num_anchors] sqrt(l^2 + w^2)
+    std::vector<int> label;        // [num_anchors] anchor 类型 = 类别
+};
+
+// AnchorDecoder 跨帧复用的候选缓冲区：每个 anchor 平面最多 H * W 个候选
+struct AnchorDecodeScratch {
+    std::vector<int> cand_pixel;    // [H * W]
+    std::vector<float> cand_logit;  // [H * W]
+    std::vector<float> cand_score;  // [候选数]
+    std::vector<float> reg;         // [7, 候选数] SoA
 };
 
 class AnchorDecoder {
 public:
     explicit AnchorDecoder(DecodeConfig cfg);
     const DecodeConfig& cfg() const { return cfg_; }
+    const AnchorTable& anchors() const { return anchors_; }
 
-    // 输入为 NCHW（float32）裸输出指针
-    std::vector<Box3D> decode(const float* box_map, const float* score_map, float score_thresh) const;
+    // 输入为 NCHW（float32）裸输出指针；dir_map 可为 nullptr（模型没有方向 head）
+    // roi 不为空时只扫描 ROI 内的像素（网格须与 cfg 一致）
+    // 输出 rot 在 [-pi, pi) 内。复用内部候选缓冲区，同一实例不能并发调用
+    std::vector<Box3D> decode(const float* box_map, const float* score_map, float score_thresh,
+                              const float* dir_map = nullptr, const RoiMask* roi = nullptr);
 
 private:
     DecodeConfig cfg_;
+    AnchorTable anchors_;
+    AnchorDecodeScratch scratch_;
 };
 
+// =========================
+// Anchor-free center head（CenterPoint 风格）decode：heatmap 峰值 + top-K，不需要 NMS
+// =========================
+struct CenterHeadConfig {
+    // heatmap / 回归 map 的尺寸，为 pillar 网格除以 out_size_factor
+    int grid_x = 432;
+    int grid_y = 496;
+    int out_size_factor = 1;
+    float voxel_size_x = 0.16f;
+    float voxel_size_y = 0.16f;
+    float x_min = 0.0f;
+    float y_min = -39.68f;
+
+    // heatmap: [1, num_classes, H, W] logit，通道即类别
+    int num_classes = 3;
+
+    // reg_map: [1, code_size, H, W]，通道依次为
+    //   0-1 cell 内中心偏移 (dx, dy)，单位为 heatmap cell
+    //   2   中心高度 z
+    //   3-5 log 尺寸 (w, l, h)，顺序同 Box3D
+    //   6-7 朝向 (sin, cos)
+    // nuScenes 模型为 10（后两个是速度，decode 时忽略）
+    int code_size = 8;
+
+    bool verbose = true;  // 打印 decode 进度
+};
+
+class CenterDecoder {
+public:
+    explicit CenterDecoder(CenterHeadConfig cfg);
+    const CenterHeadConfig& cfg() const { return cfg_; }
+
+    // 输入为 NCHW（float32）裸输出指针。峰值 = 3x3 邻域（边界外视为 -inf）内的最大值，
+    // 同 mmdet3d 的 max_pool2d 比较；所有类别的峰值合在一起取 score 最高的 max_num 个，
+    // 同分按 (类别, 像素) 排序。输出按 score 降序，rot 在 [-pi, pi) 内。
+    // 耗时上限由 map 尺寸和 max_num 决定，没有 NMS 那样随候选数平方增长的部分
+    std::vector<Box3D> decode(const float* heatmap, const float* reg_map, float score_thresh,
+                              int max_num) const;
+
+private:
+    CenterHeadConfig cfg_;
+};
+
+// 同类框之间的旋转 BEV NMS，按 score 降序处理（同分按输入下标）
 std::vector<Box3D> nms_bev_rotated(
     const std::vector<Box3D>& boxes,
     float iou_thr,
-    int max_num);
+    int max_num,
+    bool verbose = true);
+
+// 并行版本，结果与 nms_bev_rotated 完全一致：
+// 先按类别拆分，框多的类别再按空间连通块拆分（AABB 不相交的框不会互相抑制），
+// 各分区在独立线程上做贪心 NMS，最后按 score 归并到 max_num。
+// num_threads <= 0 时使用硬件线程数
+std::vector<Box3D> nms_bev_rotated_parallel(
+    const std::vector<Box3D>& boxes,
+    float iou_thr,
+    int max_num,
+    int num_threads = 0,
+    bool verbose = true);
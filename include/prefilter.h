@@ -0,0 +1,54 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Point prefilter run before Voxelizer::generate. One pass over the raw
+// [x, y, z, intensity] points crops, drops and compacts the survivors into a
+// contiguous buffer, so every downstream stage only sees useful points.
+struct PrefilterConfig {
+    // Axis-aligned crop [x_min, y_min, z_min, x_max, y_max, z_max), normally
+    // the same as VoxelConfig::point_cloud_range
+    std::array<float, 6> crop_range = {0, -39.68, -3, 69.12, 39.68, 1};
+
+    // Optional BEV region of interest (x, y vertices, any winding); empty = off
+    std::vector<std::array<float, 2>> roi_polygon;
+
+    // Height band [z_band_min, z_band_max). Raising z_band_min above the
+    // ground plane removes ground returns.
+    float z_band_min = -std::numeric_limits<float>::infinity();
+    float z_band_max = std::numeric_limits<float>::infinity();
+
+    // Points with intensity below this are dropped
+    float min_intensity = -std::numeric_limits<float>::infinity();
+
+    // Uniform downsampling: keep every n-th input point (1 = keep all)
+    int keep_every = 1;
+
+    bool verbose = true;
+};
+
+class PointPrefilter {
+public:
+    PointPrefilter(const PrefilterConfig& config);
+
+    // Filters `num_points` points from `in` into `out` (both [N, 4]) and
+    // returns the number of survivors. `out` may alias `in` for in-place use.
+    size_t apply(const float* in, size_t num_points, float* out) const;
+
+    std::vector<float> apply(const std::vector<float>& points) const;
+
+private:
+    PrefilterConfig config_;
+
+    // Per-lane bounds for [x, y, z, intensity]: lo <= v < hi
+    alignas(16) std::array<float, 4> lo_;
+    alignas(16) std::array<float, 4> hi_;
+
+    bool point_in_roi(float x, float y) const;
+};
+
+#endif // PREFILTER_H
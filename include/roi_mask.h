@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// BEV 感兴趣区域：按 pillar 网格光栅化的位图，由世界坐标多边形（多个取并集）生成。
+// cell 中心落在多边形内（奇偶规则）即属于 ROI。
+// PFN 跳过 ROI 外的 pillar，AnchorDecoder 只扫描 ROI 内的行区间，
+// 因此 NMS 不会看到 ROI 外的候选，CPU 耗时随 ROI 面积而不是传感器量程增长
+class RoiMask {
+public:
+    using Polygon = std::vector<std::array<float, 2>>;  // (x, y)，米；首尾不必重复
+
+    // 网格几何同 DecodeConfig：cell (x, y) 覆盖 [x_min + x * voxel_size_x, ...)
+    RoiMask(int grid_x, int grid_y, float x_min, float y_min, float voxel_size_x, float voxel_size_y);
+
+    // 并入一个多边形，少于 3 个点或含非有限坐标时抛异常
+    void add_polygon(const Polygon& polygon);
+    void clear();
+
+    bool contains(int x, int y) const {
+        return (bits_[static_cast<size_t>(y) * words_per_row_ + (x >> 6)] >> (x & 63)) & 1u;
+    }
+
+    // ROI 内的连续像素区间 [begin, end)，像素下标 = y * grid_x + x，按下标升序
+    const std::vector<std::pair<int32_t, int32_t>>& spans() const { return spans_; }
+    size_t num_cells() const { return num_cells_; }
+    int grid_x() const { return grid_x_; }
+    int grid_y() const { return grid_y_; }
+
+    // "x0,y0;x1,y1;..." -> Polygon（命令行 --roi 的格式）
+    static Polygon parse_polygon(const std::string& text);
+
+private:
+    int grid_x_;
+    int grid_y_;
+    float x_min_;
+    float y_min_;
+    float voxel_size_x_;
+    float voxel_size_y_;
+    size_t words_per_row_;
+    std::vector<uint64_t> bits_;                     // [grid_y, words_per_row]
+    std::vector<std::pair<int32_t, int32_t>> spans_;
+    size_t num_cells_ = 0;
+
+    void rebuild_spans();
+};
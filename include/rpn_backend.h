@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pfn.hpp"
+
+// RPN 后端接口（NPU 的 RPNRunner、CPU 替身 CpuRPN 等）
+// 输入: rpn_input_map [N, 64, 496, 432] NCHW float32
+// 输出: box_map [N, 42, 496, 432], score_map [N, 18, 496, 432]，按 batch 连续排列
+// 可选输出: 方向分类 head [N, 12, 496, 432]，由后端自己持有，通过 dir_map() 取
+class RPNBackend {
+public:
+    virtual ~RPNBackend() = default;
+
+    // 稠密输入推理，batch_size 不能超过 max_batch()
+    virtual void run(
+        const float* rpn_input_map,
+        float* box_map,
+        float* score_map,
+        int batch_size) = 0;
+
+    // 稀疏输入：[P, 64] 特征 + [P] cell 索引（含 batch 偏移）
+    // 默认实现是稠密回退：在后端自己的主机缓冲区上做 scatter 再调用 run()，
+    // 每帧只清零上一帧写过的 cell，省掉整张 map 的 memset；PFN 时序缓存给出增量信息时
+    // 只写变化的 cell（见 SparsePillars::frame）。
+    // 能直接消费稀疏输入的后端可以重写它。
+    virtual void run_sparse(
+        const SparsePillars& pillars,
+        float* box_map,
+        float* score_map);
+
+    virtual int max_batch() const { return 1; }
+
+    // 最近一次 run / run_sparse 的方向分类输出 [N, num_anchors * num_dir_bins, H, W]；
+    // 模型没有方向 head 时返回 nullptr
+    virtual const float* dir_map() const { return nullptr; }
+
+private:
+    std::vector<float> host_input_;         // run_sparse 用的稠密主机输入缓冲区
+    std::vector<int32_t> host_input_cells_; // host_input_ 中当前非零的 cell
+    uint64_t host_input_frame_ = 0;         // host_input_ 中内容的帧号（SparsePillars::frame），0 表示未知
+};
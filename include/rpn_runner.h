@@ -1,27 +1,38 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <string>
 
+#include "rpn_backend.h"
+
 // 前向声明 lynxi SDK 类型
 typedef void* lynContext_t;
 typedef void* lynStream_t;
 typedef void* lynModel_t;
 
 // RPN 运行器（基于 lynxi SDK）
-class RPNRunner {
+// 当前 NPU 模型只接受稠密输入，run_sparse 使用 RPNBackend 的稠密回退
+class RPNRunner : public RPNBackend {
 public:
-    RPNRunner(const std::string& model_path);
+    // max_batch: 设备缓冲区按该 batch 数分配，run() 的 batch_size 不能超过它
+    // device_id: 使用的芯片编号（多实例时可以把实例分到不同芯片上）
+    RPNRunner(const std::string& model_path, int max_batch = 1, int device_id = 0);
     ~RPNRunner();
     
     // 运行 RPN 推理
-    // 输入: rpn_input_map [1, 64, 496, 432] NCHW float32
-    // 输出: box_map [1, 42, 496, 432], score_map [1, 18, 496, 432]
+    // 输入: rpn_input_map [N, 64, 496, 432] NCHW float32
+    // 输出: box_map [N, 42, 496, 432], score_map [N, 18, 496, 432]
+    // 模型有第三个输出 tensor 时视为方向分类 head [N, 12, 496, 432]，通过 dir_map() 取
     void run(
         const float* rpn_input_map,
-        float* box_map,      // [1, 42, 496, 432]
-        float* score_map     // [1, 18, 496, 432]
-    );
+        float* box_map,      // [N, 42, 496, 432]
+        float* score_map,    // [N, 18, 496, 432]
+        int batch_size
+    ) override;
+
+    int max_batch() const override { return max_batch_; }
+    const float* dir_map() const override { return dir_map_.empty() ? nullptr : dir_map_.data(); }
     
 private:
     void cleanup();
@@ -34,7 +45,9 @@ private:
     void* dev_input_;   // 设备输入缓冲区
     void* dev_output_;  // 设备输出缓冲区
     float* host_output_; // 主机输出缓冲区
+    std::vector<float> dir_map_;  // 方向分类输出 [N, 12, 496, 432]，模型没有该 head 时为空
     
-    uint64_t input_size_;
-    uint64_t output_size_;
+    uint64_t input_size_;   // 单个 batch 的输入字节数
+    uint64_t output_size_;  // 单个 batch 的输出字节数
+    int max_batch_;
 };
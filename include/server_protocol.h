@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "postprocess.h"
+
+// 推理服务的二进制协议（Unix domain socket, SOCK_STREAM，主机字节序）
+//
+// 每条消息 = MessageHeader + payload_bytes 字节的负载
+//   请求 FRAME   : payload = num_points * num_features 个 float32 点
+//   请求 STATS   : 无负载，响应负载为 JSON 文本
+//   请求 HEALTH  : 无负载，响应负载为 "ok"
+//   响应 DETECTIONS : payload = num_items 个 DetectionRecord
+//   响应 ERROR   : payload = 错误信息文本
+// 同一连接上可以连续发送多帧（不必等待响应），响应按请求顺序返回。
+
+namespace pp_server {
+
+constexpr uint32_t kMagic = 0x50505346;   // "PPSF"
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kMaxPayloadBytes = 64u << 20;
+
+enum class MessageType : uint16_t {
+    Frame = 1,
+    Stats = 2,
+    Health = 3,
+    Detections = 101,
+    StatsReply = 102,
+    HealthReply = 103,
+    Error = 199,
+};
+
+#pragma pack(push, 1)
+struct MessageHeader {
+    uint32_t magic = kMagic;
+    uint16_t version = kVersion;
+    uint16_t type = 0;           // MessageType
+    uint32_t sensor_id = 0;
+    uint32_t frame_id = 0;       // 由客户端指定，响应中原样返回
+    uint32_t num_items = 0;      // FRAME: 点数; DETECTIONS: 框数
+    uint32_t num_features = 0;   // FRAME: 每点 float 数
+    uint32_t payload_bytes = 0;
+};
+
+struct DetectionRecord {
+    float x, y, z;
+    float w, l, h;
+    float rot;
+    float score;
+    int32_t label;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(MessageHeader) == 28, "MessageHeader layout");
+static_assert(sizeof(DetectionRecord) == 36, "DetectionRecord layout");
+
+// 阻塞读写一条完整消息；对端关闭返回 false，协议错误抛 std::runtime_error
+bool read_message(int fd, MessageHeader& header, std::vector<char>& payload);
+void write_message(int fd, const MessageHeader& header, const void* payload);
+
+// Box3D <-> DetectionRecord
+std::vector<DetectionRecord> to_records(const std::vector<Box3D>& boxes);
+std::vector<Box3D> from_records(const char* payload, uint32_t count);
+
+// 客户端：连接到服务端 socket
+int connect_unix(const std::string& path);
+
+} // namespace pp_server
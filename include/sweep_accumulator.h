@@ -0,0 +1,59 @@
+#ifndef SWEEP_ACCUMULATOR_H
+#define SWEEP_ACCUMULATOR_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "voxelizer.h"
+
+struct SweepConfig {
+    int max_sweeps = 10;          // ring buffer capacity K, newest sweep included
+    double max_time_lag = 0.5;    // seconds; older sweeps are left out of the output
+};
+
+// Keeps the last K lidar sweeps in a fixed ring buffer and presents them to
+// the Voxelizer as one cloud in the newest sweep's frame. Each output point is
+// [x, y, z, intensity, time_lag], so set VoxelConfig::num_point_features = 5.
+//
+// Every slot owns its raw points and its transformed output buffer; their
+// capacity is reused once the ring has wrapped. accumulate() rewrites each
+// slot's output in place and returns spans into the slots, so the sweeps are
+// never concatenated into a separate buffer.
+class SweepAccumulator {
+public:
+    SweepAccumulator(const SweepConfig& config);
+
+    // Adds a sweep of [num_points, 4] points given in its own sensor frame.
+    // `pose` is the row-major 4x4 sensor-to-world transform at `timestamp`.
+    void push(const float* points, size_t num_points,
+              const std::array<float, 16>& pose, double timestamp);
+
+    // Transforms the buffered sweeps into the newest sweep's frame and returns
+    // one [N, 5] span per sweep, newest first
+    const std::vector<PointSpan>& accumulate();
+
+    int num_sweeps() const { return count_; }
+    void reset();
+
+private:
+    struct Sweep {
+        std::vector<float> raw;        // [N, 4] sensor frame
+        std::vector<float> out;        // [N, 5] newest-sweep frame + time lag
+        std::array<float, 16> pose;
+        double timestamp = 0.0;
+        size_t num_points = 0;
+        // Transform and lag `out` was last written with; lets accumulate()
+        // skip slots whose output is already current
+        std::array<float, 12> out_transform;
+        float out_lag = -1.0f;
+    };
+
+    SweepConfig config_;
+    std::vector<Sweep> ring_;
+    int head_ = -1;   // slot of the newest sweep
+    int count_ = 0;
+    std::vector<PointSpan> spans_;
+};
+
+#endif // SWEEP_ACCUMULATOR_H
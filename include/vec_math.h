@@ -0,0 +1,47 @@
+#ifndef VEC_MATH_H
+#define VEC_MATH_H
+
+#include <cstddef>
+
+// Batched float32 transcendental kernels for the decode / NMS hot loops.
+//
+// One algorithm (Cephes-style range reduction + minimax polynomials, no FMA)
+// is instantiated for AVX-512F, AVX2, SSE2, NEON (aarch64) and plain scalar
+// code; the widest ISA enabled at compile time is used and the tail of every
+// batch goes through the scalar instantiation. Since every instantiation does
+// the same IEEE operations in the same order, results are bit-identical
+// across ISAs and batch sizes.
+//
+// vec_math.cpp is built with -ffp-contract=off so the compiler cannot fuse
+// the mul/add pairs differently per ISA.
+//
+// Error bounds against double-precision libm (dense sweep over the domain):
+//   exp     x in [-87, 88]   max relative error < 1.0e-7 (about 1 ulp)
+//           inputs outside are clamped, so exp never returns inf or a denormal
+//   sigmoid any finite x     max absolute error < 1.0e-7
+//   sincos  |x| <= 8192      max absolute error < 1.0e-7
+// NaN inputs are not propagated reliably; callers filter them first.
+//
+// Building vec_math.cpp with VECMATH_LIBM_REFERENCE replaces the kernels by
+// element-wise std::exp / std::sin / std::cos (isa_name() == "libm"); the
+// tests use it to check that detections do not depend on the kernels.
+namespace vecmath {
+
+void exp(const float* in, float* out, size_t n);
+
+// out = 1 / (1 + exp(-in))
+void sigmoid(const float* in, float* out, size_t n);
+
+void sincos(const float* in, float* sin_out, float* cos_out, size_t n);
+
+// out = max(a, b, c) lane-wise, exact. out may be one of the inputs but not
+// a shifted view of one. Used by the 3x3 max-pool peak test of the
+// center-head decoder.
+void max3(const float* a, const float* b, const float* c, float* out, size_t n);
+
+// Name of the ISA the kernels were compiled for ("avx512", "avx2", "sse2", "neon", "scalar", "libm")
+const char* isa_name();
+
+} // namespace vecmath
+
+#endif // VEC_MATH_H
@@ -3,19 +3,60 @@
 
 #include <vector>
 #include <array>
+#include <cstdint>
 #include <cstring>
 
+// How points are chosen when a voxel receives more than max_num_points
+enum class PointSampling {
+    FirstN,     // first max_num_points in arrival order
+    Stride,     // evenly spaced over all of the voxel's points (deterministic)
+    Reservoir,  // uniform random subset (reservoir sampling, seeded)
+};
+
+// Which voxels are kept when more than max_voxels cells are occupied
+enum class VoxelBudget {
+    FirstArrival,  // first max_voxels cells in point order
+    PointCount,    // densest cells first
+    NearFirst,     // nearest distance band first, denser cells first within a band
+};
+
+// Order of the emitted voxels within each frame
+enum class PillarOrder {
+    Arrival,   // order in which cells received their first point
+    RowMajor,  // by BEV cell y * grid_w + x, the NCHW scatter layout, so scatter writes stream
+    Morton,    // by Z-order of (x, y), keeps 2D neighbours close for tiled consumers
+};
+
 struct VoxelConfig {
+    int num_point_features = 4;  // floats per point: x, y, z, intensity (+ time lag for multi-sweep)
     int max_num_points = 32;
     std::array<float, 6> point_cloud_range = {0, -39.68, -3, 69.12, 39.68, 1};
     std::array<float, 3> voxel_size = {0.16, 0.16, 4};
     int max_voxels = 40000;  // for testing
+    PointSampling sampling = PointSampling::FirstN;
+    uint32_t sampling_seed = 0;  // Reservoir only; re-seeded every frame
+    VoxelBudget budget = VoxelBudget::FirstArrival;
+    float distance_band = 10.0f;  // NearFirst band width in metres (BEV range from origin)
+    PillarOrder order = PillarOrder::RowMajor;  // applied after the voxel budget
+    bool verbose = true;
+};
+
+// A contiguous block of [num_points, num_point_features] input points
+struct PointSpan {
+    const float* data;
+    size_t num_points;
 };
 
+// Pillars are one voxel tall, so a voxel is identified by its BEV cell and
+// frame alone. Indices are stored as narrow per-voxel planes (6 bytes per
+// voxel instead of 20 for int32 (batch, z, y, x) + count); consumers read
+// them directly and can load whole planes at a time.
 struct VoxelData {
-    std::vector<float> voxels;           // [num_voxels, max_num_points, 4]
-    std::vector<int> coordinates;        // [num_voxels, 4] (batch_id, z, y, x)
-    std::vector<int> num_points;         // [num_voxels]
+    std::vector<float> voxels;           // [num_voxels, max_num_points, num_point_features]
+    std::vector<uint16_t> coor_x;        // [num_voxels] BEV column
+    std::vector<uint16_t> coor_y;        // [num_voxels] BEV row
+    std::vector<uint8_t> batch_ids;      // [num_voxels] frame index within the batch
+    std::vector<uint8_t> num_points;     // [num_voxels] valid points, <= max_num_points
     int num_voxels = 0;
 };
 
@@ -24,10 +65,74 @@ public:
     Voxelizer(const VoxelConfig& config);
     
     VoxelData generate(const std::vector<float>& points);
+
+    // Voxelizes several point blocks as one cloud without concatenating them
+    VoxelData generate(const std::vector<PointSpan>& spans);
+
+    // Voxelizes several frames into one tensor; frame i gets batch_id i (at most 256 frames)
+    VoxelData generate_batch(const std::vector<std::vector<float>>& frames);
+
+    // Streaming voxelization of one frame whose points arrive in pieces (e.g.
+    // lidar packets, one azimuth sector at a time). add_points bins every
+    // point and copies it into its voxel's row on arrival, so end_frame only
+    // applies the budget and order and gathers the rows. The result equals
+    // generate() on the concatenated points, except that Reservoir draws a
+    // different random stream when a non-FirstArrival budget drops cells.
+    // Stride needs each voxel's final count and is not supported.
+    void begin_frame();
+    // [num_points, num_point_features]; not referenced after the call returns
+    void add_points(const float* points, size_t num_points);
+    VoxelData end_frame();
+    bool in_frame() const { return streaming_; }
+
+    // Changes the voxel budget for subsequent frames (e.g. a degraded real-time mode)
+    void set_max_voxels(int max_voxels);
+    int max_voxels() const { return config_.max_voxels; }
     
 private:
     VoxelConfig config_;
     std::array<int, 3> grid_size_;
+
+    // Scratch reused across frames so generate() does no per-voxel allocation
+    std::vector<int> cell_slot_;    // [grid cells] -> slot of occupied cell, -1 if empty
+    std::vector<int> point_cell_;   // [num_points] -> cell key, -1 if out of range
+    std::vector<int> slot_cell_;    // [slot] -> cell key
+    std::vector<int> slot_count_;   // [slot] -> points that fell into the cell
+    std::vector<int> slot_seen_;    // [slot] -> points visited so far in the fill pass
+    std::vector<int> slot_voxel_;   // [slot] -> output voxel index, -1 if dropped
+    std::vector<int64_t> slot_priority_;  // [slot] -> budget ranking key, higher is kept first
+    std::vector<int> slot_order_;         // selection scratch
+    std::vector<uint64_t> order_items_;   // [kept voxels] (sort key << 32) | slot
+    std::vector<uint64_t> order_tmp_;     // radix sort ping-pong buffer
+    std::vector<int> order_count_;        // radix digit histogram
+
+    // Streaming state (begin_frame .. end_frame)
+    bool streaming_ = false;
+    std::vector<float> stream_rows_;  // [slot, max_num_points, num_point_features] sampled points
+    uint32_t stream_rng_ = 0;         // Reservoir state carried across add_points calls
+
+    int select_voxels(int num_occupied);
+
+    // Renumbers slot_voxel_ so kept voxels follow config_.order (linear-time radix sort)
+    void order_voxels(int num_occupied, int num_voxels);
+
+    // Sizes `result` for num_voxels more voxels and fills their coordinates and
+    // counts; shifts slot_voxel_ to absolute rows. Point rows are left zeroed.
+    void append_voxels(int num_occupied, int num_voxels, int batch_id, VoxelData& result);
+
+    // Clears cell_slot_ for the cells occupied in the current frame
+    void reset_cells();
+
+    // Voxelizes one cloud and appends its voxels to `result` with `batch_id`
+    void generate_into(const std::vector<PointSpan>& spans, int batch_id, VoxelData& result);
+
+    // generate_into body; with StaticDims<Preset> the point width and
+    // max_num_points are compile-time constants (see pillar_config.h)
+    template <class Dims>
+    void generate_into_impl(const Dims& dims, const std::vector<PointSpan>& spans,
+                            int batch_id, VoxelData& result);
+    template <class Dims>
+    void add_points_impl(const Dims& dims, const float* points, size_t num_points);
     
     int point_to_voxel_index(float x, float y, float z);
     std::array<int, 3> point_to_grid_coords(float x, float y, float z);
@@ -29,14 +29,17 @@ class InferenceService:
         
         print("✓ ONNX session created successfully!", file=sys.stderr)
     
-    def run_inference(self, voxels_data, coors_data, num_points_data):
+    def run_inference(self, voxels_data, coor_x, coor_y, batch_ids, num_points_data,
+                      max_points=32, num_features=4):
         """
         Run inference on voxelized data.
         
         Args:
-            voxels_data: Flattened voxels array [num_voxels * 32 * 4]
-            coors_data: Flattened coordinates array [num_voxels * 4]
-            num_points_data: Flattened num_points array [num_voxels]
+            voxels_data: Flattened voxels array [num_voxels * max_points * num_features]
+            coor_x: BEV column per voxel, uint16 [num_voxels]
+            coor_y: BEV row per voxel, uint16 [num_voxels]
+            batch_ids: Frame index per voxel, uint8 [num_voxels]
+            num_points_data: Valid points per voxel, uint8 [num_voxels]
         
         Returns:
             Dictionary with 'bboxes' and 'scores' keys
@@ -46,9 +49,13 @@ class InferenceService:
         # Reshape input data
         num_voxels = len(num_points_data)
         
-        voxels = voxels_data.reshape(num_voxels, 32, 4).astype(np.float32)
-        coors = coors_data.reshape(num_voxels, 4).astype(np.int32)
-        num_points = num_points_data.reshape(num_voxels).astype(np.int32)
+        voxels = voxels_data.reshape(num_voxels, max_points, num_features).astype(np.float32, copy=False)
+        # The ONNX graph takes mmdet3d's int32 (batch, z, y, x) layout; pillars have z = 0
+        coors = np.zeros((num_voxels, 4), dtype=np.int32)
+        coors[:, 0] = batch_ids
+        coors[:, 2] = coor_y
+        coors[:, 3] = coor_x
+        num_points = num_points_data.astype(np.int32)
         
         print(f"  Voxels shape: {voxels.shape}", file=sys.stderr)
         print(f"  Coordinates shape: {coors.shape}", file=sys.stderr)
@@ -81,19 +88,26 @@ def main():
     parser = argparse.ArgumentParser(description='ONNX Inference Service')
     parser.add_argument('--onnx-model', required=True, help='ONNX model file path')
     parser.add_argument('--voxels', required=True, help='Voxels data file (binary)')
-    parser.add_argument('--coors', required=True, help='Coordinates data file (binary)')
-    parser.add_argument('--num-points', required=True, help='Num points data file (binary)')
+    parser.add_argument('--coor-x', required=True, help='Voxel BEV column file (uint16)')
+    parser.add_argument('--coor-y', required=True, help='Voxel BEV row file (uint16)')
+    parser.add_argument('--batch-ids', required=True, help='Voxel frame index file (uint8)')
+    parser.add_argument('--num-points', required=True, help='Num points data file (uint8)')
+    parser.add_argument('--max-points', type=int, default=32, help='Points per voxel slot')
+    parser.add_argument('--num-features', type=int, default=4, help='Floats per point')
     
     args = parser.parse_args()
     
     # Load data
     voxels_data = np.fromfile(args.voxels, dtype=np.float32)
-    coors_data = np.fromfile(args.coors, dtype=np.int32)
-    num_points_data = np.fromfile(args.num_points, dtype=np.int32)
+    coor_x = np.fromfile(args.coor_x, dtype=np.uint16)
+    coor_y = np.fromfile(args.coor_y, dtype=np.uint16)
+    batch_ids = np.fromfile(args.batch_ids, dtype=np.uint8)
+    num_points_data = np.fromfile(args.num_points, dtype=np.uint8)
     
     # Run inference
     service = InferenceService(args.onnx_model)
-    result = service.run_inference(voxels_data, coors_data, num_points_data)
+    result = service.run_inference(voxels_data, coor_x, coor_y, batch_ids, num_points_data,
+                                   args.max_points, args.num_features)
     
     # Output as JSON
     print(json.dumps(result))
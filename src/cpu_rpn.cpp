@@ -0,0 +1,130 @@
+#include "cpu_rpn.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+CpuRPN::CpuRPN(const CpuRPNConfig& config) : config_(config) {
+    if (config_.max_batch < 1) {
+        throw std::invalid_argument("CpuRPNConfig: max_batch must be >= 1");
+    }
+    
+    if (config_.dir_channels < 0) {
+        throw std::invalid_argument("CpuRPNConfig: dir_channels must be >= 0");
+    }
+    
+    const int out_channels = this->out_channels();
+    weights_.resize(static_cast<size_t>(out_channels) * config_.in_channels);
+    bias_.assign(out_channels, 0.0f);
+    dir_map_.resize(static_cast<size_t>(config_.max_batch) * config_.dir_channels *
+                    config_.grid_h * config_.grid_w);
+    
+    // 权重幅度足够小，保证 box 回归值落在 decode 的合理范围内
+    std::mt19937 rng(config_.seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    const float scale = 0.1f / config_.in_channels;
+    for (auto& w : weights_) {
+        w = dist(rng) * scale;
+    }
+    for (int o = config_.box_channels; o < config_.box_channels + config_.score_channels; ++o) {
+        bias_[o] = config_.score_bias;
+    }
+}
+
+float* CpuRPN::output_plane(int o, size_t b, float* box_map, float* score_map) {
+    const size_t plane = static_cast<size_t>(config_.grid_h) * config_.grid_w;
+    if (o < config_.box_channels) {
+        return box_map + (b * config_.box_channels + o) * plane;
+    }
+    o -= config_.box_channels;
+    if (o < config_.score_channels) {
+        return score_map + (b * config_.score_channels + o) * plane;
+    }
+    o -= config_.score_channels;
+    return dir_map_.data() + (b * config_.dir_channels + o) * plane;
+}
+
+void CpuRPN::fill_bias(float* box_map, float* score_map, int batch_size) {
+    const size_t plane = static_cast<size_t>(config_.grid_h) * config_.grid_w;
+    for (int b = 0; b < batch_size; ++b) {
+        for (int o = 0; o < out_channels(); ++o) {
+            float* dst = output_plane(o, b, box_map, score_map);
+            std::fill(dst, dst + plane, bias_[o]);
+        }
+    }
+}
+
+void CpuRPN::simulate_latency() const {
+    if (config_.simulated_latency_ms > 0.0f) {
+        std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(config_.simulated_latency_ms));
+    }
+}
+
+void CpuRPN::run(
+    const float* rpn_input_map,
+    float* box_map,
+    float* score_map,
+    int batch_size) {
+    
+    if (batch_size < 1 || batch_size > config_.max_batch) {
+        throw std::runtime_error("CpuRPN: batch_size 超出范围 [1, max_batch]");
+    }
+    
+    const size_t plane = static_cast<size_t>(config_.grid_h) * config_.grid_w;
+    const int C = config_.in_channels;
+    fill_bias(box_map, score_map, batch_size);
+    
+    // out[o][:] += w[o][c] * in[c][:]，内层是连续的整行，编译器可以向量化
+    for (int b = 0; b < batch_size; ++b) {
+        const float* in = rpn_input_map + static_cast<size_t>(b) * C * plane;
+        for (int o = 0; o < out_channels(); ++o) {
+            float* dst = output_plane(o, b, box_map, score_map);
+            for (int c = 0; c < C; ++c) {
+                const float w = weights_[static_cast<size_t>(o) * C + c];
+                const float* src = in + c * plane;
+                for (size_t i = 0; i < plane; ++i) {
+                    dst[i] += w * src[i];
+                }
+            }
+        }
+    }
+    
+    simulate_latency();
+}
+
+void CpuRPN::run_sparse(
+    const SparsePillars& pillars,
+    float* box_map,
+    float* score_map) {
+    
+    if (pillars.batch_size > config_.max_batch) {
+        throw std::runtime_error("CpuRPN: batch_size 超出范围 [1, max_batch]");
+    }
+    if (pillars.channels != config_.in_channels ||
+        pillars.grid_h != config_.grid_h || pillars.grid_w != config_.grid_w) {
+        throw std::runtime_error("CpuRPN: 稀疏输入尺寸与配置不匹配");
+    }
+    
+    const size_t plane = static_cast<size_t>(config_.grid_h) * config_.grid_w;
+    const int C = config_.in_channels;
+    fill_bias(box_map, score_map, pillars.batch_size);
+    
+    for (int p = 0; p < pillars.num_pillars; ++p) {
+        const float* feature = pillars.features.data() + static_cast<size_t>(p) * C;
+        const size_t cell = pillars.cell_indices[p];
+        const size_t batch = cell / plane;
+        const size_t pixel = cell - batch * plane;
+        
+        for (int o = 0; o < out_channels(); ++o) {
+            const float* w = weights_.data() + static_cast<size_t>(o) * C;
+            float sum = bias_[o];
+            for (int c = 0; c < C; ++c) {
+                sum += w[c] * feature[c];
+            }
+            output_plane(o, batch, box_map, score_map)[pixel] = sum;
+        }
+    }
+    
+    simulate_latency();
+}
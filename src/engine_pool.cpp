@@ -0,0 +1,367 @@
+#include "engine_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_between(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// 处理耗时估计的指数滑动平均系数
+constexpr double kCostSmoothing = 0.2;
+
+// 把当前线程绑定到给定 CPU 集合；非 Linux 平台或失败时只打印警告
+void pin_current_thread(const std::vector<int>& cpus, int instance) {
+    if (cpus.empty()) return;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        std::cerr << "EnginePool: 实例 " << instance << " 绑核失败，错误码: " << err << std::endl;
+    }
+#else
+    std::cerr << "EnginePool: 当前平台不支持绑核，实例 " << instance << " 不绑定" << std::endl;
+#endif
+}
+
+} // namespace
+
+std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!file) return cpus;
+    
+    std::string list;
+    std::getline(file, list);
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int lo = std::stoi(range.substr(0, dash));
+        int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+    }
+    return cpus;
+}
+
+struct EnginePool::Instance {
+    struct Job {
+        int sensor_id = 0;
+        std::vector<float> points;
+        std::promise<std::vector<Box3D>> result;
+        Clock::time_point submitted;
+    };
+    
+    int index = 0;
+    std::vector<int> cpus;
+    std::unique_ptr<Pipeline> pipeline;
+    std::thread thread;
+    
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<Job> queue;
+    bool busy = false;  // 工作线程正在处理一帧（用于按负载路由）
+    bool stopping = false;
+    
+    // 统计（受 mutex 保护）
+    Clock::time_point started;
+    uint64_t frames = 0;
+    uint64_t failed = 0;
+    uint64_t dropped = 0;
+    double busy_ms = 0;
+    double latency_sum_ms = 0;
+    double max_latency_ms = 0;
+    size_t max_queue_depth = 0;
+    uint64_t degraded = 0;
+    uint64_t expired = 0;
+    uint64_t deadline_missed = 0;
+    
+    // 最近的处理耗时估计（只由工作线程读写），0 表示还没有样本
+    double full_cost_ms = 0;
+    double degraded_cost_ms = 0;
+};
+
+EnginePool::EnginePool(const EnginePoolConfig& config, PipelineFactory factory)
+    : config_(config) {
+    
+    if (config_.num_instances < 1) {
+        throw std::invalid_argument("EnginePool: num_instances must be >= 1");
+    }
+    if (config_.queue_capacity < 1) {
+        throw std::invalid_argument("EnginePool: queue_capacity must be >= 1");
+    }
+    for (const auto& kv : config_.sensor_routes) {
+        if (kv.second < 0 || kv.second >= config_.num_instances) {
+            throw std::invalid_argument("EnginePool: sensor route " + std::to_string(kv.first) +
+                                        " 指向不存在的实例 " + std::to_string(kv.second));
+        }
+    }
+    
+    for (int i = 0; i < config_.num_instances; ++i) {
+        auto inst = std::make_unique<Instance>();
+        inst->index = i;
+        if (i < static_cast<int>(config_.instance_cpus.size())) {
+            inst->cpus = config_.instance_cpus[i];
+        } else if (i < static_cast<int>(config_.instance_numa_nodes.size()) &&
+                   config_.instance_numa_nodes[i] >= 0) {
+            inst->cpus = numa_node_cpus(config_.instance_numa_nodes[i]);
+            if (inst->cpus.empty()) {
+                std::cerr << "EnginePool: 读取 NUMA 节点 " << config_.instance_numa_nodes[i]
+                          << " 的 CPU 列表失败，实例 " << i << " 不绑定" << std::endl;
+            }
+        }
+        instances_.push_back(std::move(inst));
+    }
+    
+    // 逐个启动工作线程并等待 Pipeline 构造完成。
+    // promise 移交给工作线程持有：get() 返回时 set_value 可能还没退出，不能留在本循环的栈上
+    for (auto& inst : instances_) {
+        std::promise<void> ready;
+        auto ready_future = ready.get_future();
+        Instance& ref = *inst;
+        inst->thread = std::thread([this, &ref, &factory, p = std::move(ready)]() mutable {
+            worker_loop(ref, factory, p);
+        });
+        try {
+            ready_future.get();
+        } catch (...) {
+            inst->thread.join();
+            shutdown();
+            throw;
+        }
+    }
+}
+
+EnginePool::~EnginePool() {
+    shutdown();
+}
+
+void EnginePool::worker_loop(Instance& inst, const PipelineFactory& factory,
+                             std::promise<void>& ready) {
+    pin_current_thread(inst.cpus, inst.index);
+    
+    try {
+        inst.pipeline = factory(inst.index);
+        if (!inst.pipeline) {
+            throw std::runtime_error("EnginePool: factory returned null pipeline");
+        }
+    } catch (...) {
+        ready.set_exception(std::current_exception());
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(inst.mutex);
+        inst.started = Clock::now();
+    }
+    ready.set_value();
+    
+    while (true) {
+        Instance::Job job;
+        {
+            std::unique_lock<std::mutex> lock(inst.mutex);
+            inst.busy = false;
+            inst.not_empty.wait(lock, [&] { return inst.stopping || !inst.queue.empty(); });
+            if (inst.queue.empty()) break;  // stopping 且已排空
+            job = std::move(inst.queue.front());
+            inst.queue.pop_front();
+            inst.busy = true;
+        }
+        inst.not_full.notify_one();
+        
+        // 实时调度：按剩余时间选择处理质量，或者直接丢弃
+        FrameQuality quality = FrameQuality::Full;
+        if (config_.deadline_ms > 0) {
+            const double remaining = config_.deadline_ms - ms_between(job.submitted, Clock::now());
+            if (config_.allow_degrade && remaining < inst.full_cost_ms) {
+                quality = FrameQuality::Degraded;
+            }
+            const double cost = quality == FrameQuality::Full ? inst.full_cost_ms : inst.degraded_cost_ms;
+            if (config_.drop_expired && remaining < cost) {
+                {
+                    std::lock_guard<std::mutex> lock(inst.mutex);
+                    ++inst.expired;
+                }
+                job.result.set_exception(std::make_exception_ptr(FrameExpired(
+                    "EnginePool: 帧已超过截止时间 (剩余 " + std::to_string(remaining) + " ms)")));
+                continue;
+            }
+        }
+        
+        const auto t0 = Clock::now();
+        std::vector<Box3D> boxes;
+        std::exception_ptr error;
+        try {
+            boxes = inst.pipeline->process(job.points, nullptr, quality, job.sensor_id);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        const auto t1 = Clock::now();
+        
+        const double cost = ms_between(t0, t1);
+        double& estimate = quality == FrameQuality::Full ? inst.full_cost_ms : inst.degraded_cost_ms;
+        estimate = estimate == 0 ? cost : estimate + kCostSmoothing * (cost - estimate);
+        
+        // 先记统计再交付结果，调用方拿到结果后读到的统计已包含这一帧
+        {
+            std::lock_guard<std::mutex> lock(inst.mutex);
+            const double latency = ms_between(job.submitted, t1);
+            inst.busy_ms += cost;
+            if (!error) {
+                ++inst.frames;
+                inst.latency_sum_ms += latency;
+                inst.max_latency_ms = std::max(inst.max_latency_ms, latency);
+                if (quality == FrameQuality::Degraded) ++inst.degraded;
+                if (config_.deadline_ms > 0 && latency > config_.deadline_ms) ++inst.deadline_missed;
+            } else {
+                ++inst.failed;
+            }
+        }
+        if (error) {
+            job.result.set_exception(error);
+        } else {
+            job.result.set_value(std::move(boxes));
+        }
+    }
+    
+    // Pipeline（以及 RPNRunner 的 Context）在创建它的线程上释放
+    inst.pipeline.reset();
+}
+
+int EnginePool::route(int sensor_id) const {
+    auto it = config_.sensor_routes.find(sensor_id);
+    if (it != config_.sensor_routes.end()) {
+        return it->second;
+    }
+    if (!config_.sensor_affinity) {
+        return -1;
+    }
+    const int n = num_instances();
+    return ((sensor_id % n) + n) % n;
+}
+
+EnginePool::Instance& EnginePool::least_loaded() {
+    const unsigned n = static_cast<unsigned>(instances_.size());
+    const unsigned first = next_instance_.fetch_add(1, std::memory_order_relaxed) % n;
+    Instance* best = nullptr;
+    size_t best_load = 0;
+    for (unsigned k = 0; k < n; ++k) {
+        Instance& inst = *instances_[(first + k) % n];
+        size_t load;
+        {
+            std::lock_guard<std::mutex> lock(inst.mutex);
+            load = inst.queue.size() + (inst.busy ? 1 : 0);
+        }
+        if (!best || load < best_load) {
+            best = &inst;
+            best_load = load;
+        }
+    }
+    return *best;
+}
+
+std::future<std::vector<Box3D>> EnginePool::submit(int sensor_id, std::vector<float> points) {
+    const int fixed = route(sensor_id);
+    Instance& inst = fixed >= 0 ? *instances_[fixed] : least_loaded();
+    
+    Instance::Job job;
+    job.sensor_id = sensor_id;
+    job.points = std::move(points);
+    job.submitted = Clock::now();
+    auto future = job.result.get_future();
+    
+    {
+        std::unique_lock<std::mutex> lock(inst.mutex);
+        if (inst.stopping) {
+            throw std::runtime_error("EnginePool: submit after shutdown");
+        }
+        if (inst.queue.size() >= config_.queue_capacity) {
+            if (config_.drop_when_full) {
+                ++inst.dropped;
+                job.result.set_exception(std::make_exception_ptr(
+                    std::runtime_error("EnginePool: 实例 " + std::to_string(inst.index) + " 队列已满，丢帧")));
+                return future;
+            }
+            inst.not_full.wait(lock, [&] {
+                return inst.stopping || inst.queue.size() < config_.queue_capacity;
+            });
+            if (inst.stopping) {
+                throw std::runtime_error("EnginePool: submit after shutdown");
+            }
+        }
+        inst.queue.push_back(std::move(job));
+        inst.max_queue_depth = std::max(inst.max_queue_depth, inst.queue.size());
+    }
+    inst.not_empty.notify_one();
+    return future;
+}
+
+std::vector<InstanceStats> EnginePool::stats() const {
+    std::vector<InstanceStats> result;
+    const auto now = Clock::now();
+    for (const auto& inst : instances_) {
+        std::lock_guard<std::mutex> lock(inst->mutex);
+        InstanceStats s;
+        s.instance = inst->index;
+        s.frames = inst->frames;
+        s.failed = inst->failed;
+        s.dropped = inst->dropped;
+        s.busy_ms = inst->busy_ms;
+        s.mean_latency_ms = inst->frames ? inst->latency_sum_ms / inst->frames : 0.0;
+        s.max_latency_ms = inst->max_latency_ms;
+        const double uptime_ms = ms_between(inst->started, now);
+        if (uptime_ms > 0) {
+            s.fps = 1000.0 * inst->frames / uptime_ms;
+            s.utilization = inst->busy_ms / uptime_ms;
+        }
+        s.queue_depth = inst->queue.size();
+        s.max_queue_depth = inst->max_queue_depth;
+        s.degraded = inst->degraded;
+        s.expired = inst->expired;
+        s.deadline_missed = inst->deadline_missed;
+        // 队列满被丢弃的帧同样算作没赶上
+        const uint64_t scheduled = inst->frames + inst->expired + inst->dropped;
+        const uint64_t missed = inst->expired + inst->deadline_missed + inst->dropped;
+        s.miss_rate = scheduled ? static_cast<double>(missed) / scheduled : 0.0;
+        result.push_back(s);
+    }
+    return result;
+}
+
+void EnginePool::shutdown() {
+    for (auto& inst : instances_) {
+        {
+            std::lock_guard<std::mutex> lock(inst->mutex);
+            inst->stopping = true;
+        }
+        inst->not_empty.notify_all();
+        inst->not_full.notify_all();
+    }
+    for (auto& inst : instances_) {
+        if (inst->thread.joinable()) {
+            inst->thread.join();
+        }
+    }
+}
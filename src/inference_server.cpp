@@ -0,0 +1,352 @@
+#include "inference_server.h"
+#include "server_protocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using pp_server::MessageHeader;
+using pp_server::MessageType;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+MessageHeader reply_header(const MessageHeader& request, MessageType type,
+                           uint32_t num_items, uint32_t payload_bytes) {
+    MessageHeader h;
+    h.type = static_cast<uint16_t>(type);
+    h.sensor_id = request.sensor_id;
+    h.frame_id = request.frame_id;
+    h.num_items = num_items;
+    h.payload_bytes = payload_bytes;
+    return h;
+}
+
+// 一条待返回的响应：帧请求带 future，其余请求在读取时就已生成文本
+struct PendingReply {
+    MessageHeader request;
+    MessageType type;
+    std::future<std::vector<Box3D>> result;
+    std::string text;
+    Clock::time_point received;
+};
+
+} // namespace
+
+InferenceServer::InferenceServer(const ServerConfig& config, EnginePool& pool)
+    : config_(config), pool_(pool), started_(Clock::now()) {
+    
+    if (config_.latency_window < 1) {
+        throw std::invalid_argument("InferenceServer: latency_window must be >= 1");
+    }
+    latency_window_.reserve(config_.latency_window);
+    
+    sockaddr_un addr{};
+    if (config_.socket_path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket 路径过长: " + config_.socket_path);
+    }
+    
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("socket 失败: ") + std::strerror(errno));
+    }
+    
+    // 清理上次异常退出残留的 socket 文件
+    ::unlink(config_.socket_path.c_str());
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, config_.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, config_.max_clients) != 0) {
+        int err = errno;
+        ::close(listen_fd_);
+        throw std::runtime_error("监听 " + config_.socket_path + " 失败: " + std::strerror(err));
+    }
+}
+
+InferenceServer::~InferenceServer() {
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(config_.socket_path.c_str());
+    }
+}
+
+void InferenceServer::run() {
+    std::cout << "✓ 推理服务已启动: " << config_.socket_path << std::endl;
+    
+    while (!stopping_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200);  // 定期醒来检查 stopping_
+        reap_finished_clients();
+        if (ready <= 0) continue;
+        
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        if (static_cast<int>(client_fds_.size()) >= config_.max_clients) {
+            std::cerr << "InferenceServer: 连接数已满，拒绝新连接" << std::endl;
+            ::close(fd);
+            continue;
+        }
+        client_fds_.insert(fd);
+        const uint64_t id = total_connections_++;
+        client_threads_.emplace(id, std::thread(&InferenceServer::serve_client, this, fd, id));
+    }
+    
+    // 停止：打断所有阻塞在 recv 上的连接，等待它们把已提交的帧返回完
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        for (int fd : client_fds_) {
+            ::shutdown(fd, SHUT_RD);
+        }
+    }
+    for (auto& entry : client_threads_) {
+        entry.second.join();
+    }
+    client_threads_.clear();
+    finished_clients_.clear();
+    std::cout << "✓ 推理服务已停止" << std::endl;
+}
+
+void InferenceServer::reap_finished_clients() {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        for (uint64_t id : finished_clients_) {
+            auto it = client_threads_.find(id);
+            finished.push_back(std::move(it->second));
+            client_threads_.erase(it);
+        }
+        finished_clients_.clear();
+    }
+    // 线程已经走到 serve_client 末尾，join 很快返回
+    for (auto& t : finished) {
+        t.join();
+    }
+}
+
+void InferenceServer::serve_client(int fd, uint64_t id) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<PendingReply> pending;
+    bool reader_done = false;
+    bool writer_failed = false;
+    
+    // 写线程：按请求顺序等待结果并发送
+    std::thread writer([&]() {
+        while (true) {
+            PendingReply reply;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return reader_done || !pending.empty(); });
+                if (pending.empty()) break;
+                reply = std::move(pending.front());
+                pending.pop_front();
+            }
+            cv.notify_all();
+            
+            try {
+                if (reply.type == MessageType::Detections) {
+                    // 推理失败时返回 ERROR 消息，连接继续可用
+                    std::vector<Box3D> boxes;
+                    std::string error;
+                    try {
+                        boxes = reply.result.get();
+                    } catch (const std::exception& e) {
+                        error = e.what();
+                    }
+                    if (error.empty()) {
+                        auto records = pp_server::to_records(boxes);
+                        const uint32_t bytes = static_cast<uint32_t>(records.size() * sizeof(records[0]));
+                        pp_server::write_message(fd, reply_header(reply.request, MessageType::Detections,
+                                                                  static_cast<uint32_t>(records.size()), bytes),
+                                                 records.data());
+                    } else {
+                        pp_server::write_message(fd, reply_header(reply.request, MessageType::Error, 0,
+                                                                  static_cast<uint32_t>(error.size())),
+                                                 error.data());
+                    }
+                    record_frame(ms_since(reply.received), error.empty());
+                } else {
+                    pp_server::write_message(fd, reply_header(reply.request, reply.type, 0,
+                                                              static_cast<uint32_t>(reply.text.size())),
+                                             reply.text.data());
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "InferenceServer: 发送失败: " << e.what() << std::endl;
+                std::lock_guard<std::mutex> lock(mutex);
+                writer_failed = true;
+                ::shutdown(fd, SHUT_RD);  // 让读循环退出
+                pending.clear();
+                cv.notify_all();
+                break;
+            }
+        }
+    });
+    
+    // 读循环
+    MessageHeader header;
+    std::vector<char> payload;
+    try {
+        while (pp_server::read_message(fd, header, payload)) {
+            PendingReply reply;
+            reply.request = header;
+            reply.received = Clock::now();
+            
+            switch (static_cast<MessageType>(header.type)) {
+            case MessageType::Frame: {
+                const uint64_t expected = static_cast<uint64_t>(header.num_items) * header.num_features * sizeof(float);
+                if (static_cast<int>(header.num_features) != config_.num_point_features ||
+                    expected != header.payload_bytes) {
+                    reply.type = MessageType::Error;
+                    reply.text = "帧格式错误: 需要 num_features=" + std::to_string(config_.num_point_features) +
+                                 " 且 payload = num_points * num_features * 4";
+                    std::lock_guard<std::mutex> lock(stats_mutex_);
+                    ++protocol_errors_;
+                    break;
+                }
+                std::vector<float> points(header.payload_bytes / sizeof(float));
+                std::memcpy(points.data(), payload.data(), header.payload_bytes);
+                reply.type = MessageType::Detections;
+                {
+                    std::lock_guard<std::mutex> lock(stats_mutex_);
+                    ++frames_received_;
+                }
+                try {
+                    reply.result = pool_.submit(static_cast<int>(header.sensor_id), std::move(points));
+                } catch (...) {
+                    std::promise<std::vector<Box3D>> failed;
+                    failed.set_exception(std::current_exception());
+                    reply.result = failed.get_future();
+                }
+                break;
+            }
+            case MessageType::Stats:
+                reply.type = MessageType::StatsReply;
+                reply.text = stats_json();
+                break;
+            case MessageType::Health:
+                reply.type = MessageType::HealthReply;
+                reply.text = "ok";
+                break;
+            default:
+                reply.type = MessageType::Error;
+                reply.text = "未知消息类型: " + std::to_string(header.type);
+                break;
+            }
+            
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] {
+                return writer_failed || pending.size() < config_.max_inflight_per_client;
+            });
+            if (writer_failed) break;
+            pending.push_back(std::move(reply));
+            cv.notify_all();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "InferenceServer: 连接读取出错: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++protocol_errors_;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reader_done = true;
+    }
+    cv.notify_all();
+    writer.join();
+    
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        client_fds_.erase(fd);
+        finished_clients_.push_back(id);
+    }
+    ::close(fd);
+}
+
+void InferenceServer::record_frame(double latency_ms, bool ok) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (!ok) {
+        ++frames_failed_;
+        return;
+    }
+    ++frames_ok_;
+    if (latency_window_.size() < config_.latency_window) {
+        latency_window_.push_back(latency_ms);
+    } else {
+        latency_window_[latency_next_] = latency_ms;
+        latency_next_ = (latency_next_ + 1) % config_.latency_window;
+    }
+    latency_max_ms_ = std::max(latency_max_ms_, latency_ms);
+}
+
+std::string InferenceServer::stats_json() const {
+    const double uptime_s = ms_since(started_) / 1000.0;
+    std::ostringstream j;
+    
+    std::vector<double> window;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        j << "{\"uptime_s\":" << uptime_s
+          << ",\"frames_received\":" << frames_received_
+          << ",\"frames_ok\":" << frames_ok_
+          << ",\"frames_failed\":" << frames_failed_
+          << ",\"protocol_errors\":" << protocol_errors_
+          << ",\"fps\":" << (uptime_s > 0 ? frames_ok_ / uptime_s : 0.0)
+          << ",\"latency_max_ms\":" << latency_max_ms_;
+        window = latency_window_;
+    }
+    
+    std::sort(window.begin(), window.end());
+    auto pct = [&](double p) {
+        if (window.empty()) return 0.0;
+        return window[static_cast<size_t>(p / 100.0 * (window.size() - 1) + 0.5)];
+    };
+    j << ",\"latency_window\":" << window.size()
+      << ",\"latency_p50_ms\":" << pct(50)
+      << ",\"latency_p90_ms\":" << pct(90)
+      << ",\"latency_p99_ms\":" << pct(99);
+    
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        j << ",\"active_connections\":" << client_fds_.size()
+          << ",\"total_connections\":" << total_connections_;
+    }
+    
+    j << ",\"instances\":[";
+    const auto instances = pool_.stats();
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const auto& s = instances[i];
+        j << (i ? "," : "")
+          << "{\"instance\":" << s.instance
+          << ",\"frames\":" << s.frames
+          << ",\"failed\":" << s.failed
+          << ",\"dropped\":" << s.dropped
+          << ",\"fps\":" << s.fps
+          << ",\"utilization\":" << s.utilization
+          << ",\"mean_latency_ms\":" << s.mean_latency_ms
+          << ",\"max_latency_ms\":" << s.max_latency_ms
+          << ",\"queue_depth\":" << s.queue_depth
+          << ",\"degraded\":" << s.degraded
+          << ",\"expired\":" << s.expired
+          << ",\"deadline_missed\":" << s.deadline_missed
+          << ",\"miss_rate\":" << s.miss_rate << "}";
+    }
+    j << "]}";
+    return j.str();
+}
@@ -6,13 +6,20 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "voxelizer.h"
+#include "prefilter.h"
+#include "sweep_accumulator.h"
 #include "pfn.hpp"
+#include "model_bundle.h"
 #include "rpn_runner.h"
 #include "postprocess.h"
+#include "roi_mask.h"
+#include "pillar_config.h"
 
 // 读取二进制文件
 std::vector<float> load_bin(const char* path) {
@@ -44,6 +51,38 @@ std::vector<float> load_pointcloud(const std::string& path) {
     return points;
 }
 
+// 多帧列表文件：每行 "<点云.bin> <时间戳秒> <4x4 位姿, 行主序 16 个数>"
+// 位姿为 sensor -> world，按时间从旧到新排列，最后一行是当前帧
+struct SweepEntry {
+    std::string path;
+    double timestamp;
+    std::array<float, 16> pose;
+};
+
+std::vector<SweepEntry> load_sweep_list(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("无法打开多帧列表: " + path);
+    }
+    std::vector<SweepEntry> entries;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        SweepEntry e;
+        ss >> e.path >> e.timestamp;
+        for (auto& v : e.pose) ss >> v;
+        if (!ss) {
+            throw std::runtime_error("多帧列表格式错误: " + line);
+        }
+        entries.push_back(e);
+    }
+    if (entries.empty()) {
+        throw std::runtime_error("多帧列表为空: " + path);
+    }
+    return entries;
+}
+
 void print_boxes(const std::vector<Box3D>& boxes) {
     std::cout << "\n" << std::string(80, '=') << std::endl;
     std::cout << "检测结果" << std::endl;
@@ -75,10 +114,21 @@ int main(int argc, char* argv[]) {
     std::string pointcloud_file = project_root + "/test/kitti_000008.bin";
     std::string pfn_weight = project_root + "/pfn_weight.bin";
     std::string pfn_bias = project_root + "/pfn_bias.bin";
+    std::string pfn_bn;  // BatchNorm 参数前缀：<prefix>_gamma.bin / _beta.bin / _mean.bin / _var.bin
     std::string rpn_model = project_root + "/rpn_lynxi/Net_0/apu_0/apu_x/lyn__2026-01-28-11-13-55-749707.mdl";  // 默认路径
+    bool rpn_model_set = false;
+    std::string bundle_path;  // 模型包：PFN 权重 + 体素 / decode 配置 + RPN 路径
     float score_thr = 0.3f;
     float nms_thr = 0.01f;
     int max_num = 100;
+    int nms_pre = 0;  // 只把 score 最高的 nms_pre 个候选送进 NMS，0 = 不限
+    PrefilterConfig prefilter_config;
+    VoxelConfig voxel_config;
+    std::string sweep_list;
+    SweepConfig sweep_config;
+    bool dynamic_voxel = false;
+    int stream_chunks = 0;  // >0: 把点云分成这么多块依次送入流式体素化，模拟按扇区到达的数据包
+    std::vector<RoiMask::Polygon> roi_polygons;
     
     // 解析命令行参数
     for (int i = 1; i < argc; ++i) {
@@ -89,28 +139,113 @@ int main(int argc, char* argv[]) {
             pfn_weight = argv[++i];
         } else if (arg == "--pfn-bias" && i + 1 < argc) {
             pfn_bias = argv[++i];
+        } else if (arg == "--pfn-bn" && i + 1 < argc) {
+            pfn_bn = argv[++i];
         } else if (arg == "--rpn-model" && i + 1 < argc) {
             rpn_model = argv[++i];
+            rpn_model_set = true;
+        } else if (arg == "--bundle" && i + 1 < argc) {
+            bundle_path = argv[++i];
         } else if (arg == "--score-thr" && i + 1 < argc) {
             score_thr = std::stof(argv[++i]);
         } else if (arg == "--nms-thr" && i + 1 < argc) {
             nms_thr = std::stof(argv[++i]);
         } else if (arg == "--max-num" && i + 1 < argc) {
             max_num = std::stoi(argv[++i]);
+        } else if (arg == "--roi" && i + 1 < argc) {
+            roi_polygons.push_back(RoiMask::parse_polygon(argv[++i]));
+        } else if (arg == "--nms-pre" && i + 1 < argc) {
+            nms_pre = std::stoi(argv[++i]);
+        } else if (arg == "--ground-z" && i + 1 < argc) {
+            prefilter_config.z_band_min = std::stof(argv[++i]);
+        } else if (arg == "--min-intensity" && i + 1 < argc) {
+            prefilter_config.min_intensity = std::stof(argv[++i]);
+        } else if (arg == "--keep-every" && i + 1 < argc) {
+            prefilter_config.keep_every = std::stoi(argv[++i]);
+        } else if (arg == "--point-sampling" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "first") {
+                voxel_config.sampling = PointSampling::FirstN;
+            } else if (mode == "stride") {
+                voxel_config.sampling = PointSampling::Stride;
+            } else if (mode == "reservoir") {
+                voxel_config.sampling = PointSampling::Reservoir;
+            } else {
+                std::cerr << "未知的 --point-sampling: " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--max-voxels" && i + 1 < argc) {
+            voxel_config.max_voxels = std::stoi(argv[++i]);
+        } else if (arg == "--voxel-budget" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "first") {
+                voxel_config.budget = VoxelBudget::FirstArrival;
+            } else if (mode == "count") {
+                voxel_config.budget = VoxelBudget::PointCount;
+            } else if (mode == "near") {
+                voxel_config.budget = VoxelBudget::NearFirst;
+            } else {
+                std::cerr << "未知的 --voxel-budget: " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--pillar-order" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "arrival") {
+                voxel_config.order = PillarOrder::Arrival;
+            } else if (mode == "row") {
+                voxel_config.order = PillarOrder::RowMajor;
+            } else if (mode == "morton") {
+                voxel_config.order = PillarOrder::Morton;
+            } else {
+                std::cerr << "未知的 --pillar-order: " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--dynamic-voxel") {
+            dynamic_voxel = true;
+        } else if (arg == "--stream-chunks" && i + 1 < argc) {
+            stream_chunks = std::stoi(argv[++i]);
+        } else if (arg == "--sweep-list" && i + 1 < argc) {
+            sweep_list = argv[++i];
+        } else if (arg == "--max-sweeps" && i + 1 < argc) {
+            sweep_config.max_sweeps = std::stoi(argv[++i]);
         } else if (arg == "--help" || arg == "-h") {
             std::cout << "用法: " << argv[0] << " [选项]\n"
                       << "选项:\n"
                       << "  --pointcloud <path>    点云文件 (默认: test/kitti_000008.bin)\n"
                       << "  --pfn-weight <path>    PFN权重 (默认: pfn_weight.bin)\n"
                       << "  --pfn-bias <path>      PFN偏置 (默认: pfn_bias.bin)\n"
+                      << "  --bundle <path>        模型包 (pack_bundle 生成)：取代 PFN 权重 / 偏置 / BN、\n"
+                      << "                         体素与 decode 配置；包内有 RPN 路径且未给 --rpn-model 时使用它\n"
+                      << "  --pfn-bn <prefix>      PFN BatchNorm 参数 <prefix>_{gamma,beta,mean,var}.bin，\n"
+                      << "                         加载时折叠进权重，max 后做 ReLU (默认: 不加载)\n"
                       << "  --rpn-model <path>     RPN模型路径\n"
                       << "  --score-thr <float>   分数阈值 (默认: 0.3)\n"
                       << "  --nms-thr <float>     NMS阈值 (默认: 0.01)\n"
-                      << "  --max-num <int>       最大检测数 (默认: 100)\n";
+                      << "  --max-num <int>       最大检测数 (默认: 100)\n"
+                      << "  --nms-pre <int>       只把 score 最高的 n 个候选送进 NMS (默认: 0 不限)\n"
+                      << "  --roi <x,y;x,y;...>   BEV 感兴趣区域多边形（米），可重复，取并集；\n"
+                      << "                         ROI 外的 pillar 和候选框直接跳过 (默认: 整个网格)\n"
+                      << "  --ground-z <float>    预过滤: 丢弃低于该高度的点 (地面去除)\n"
+                      << "  --min-intensity <f>   预过滤: 丢弃强度低于该值的点\n"
+                      << "  --keep-every <int>    预过滤: 每 n 个点保留 1 个 (默认: 1)\n"
+                      << "  --point-sampling <m>  pillar 超过 32 点时的采样: first|stride|reservoir (默认: first)\n"
+                      << "  --max-voxels <int>    最大 pillar 数 (默认: 40000)\n"
+                      << "  --voxel-budget <m>    超出 max-voxels 时保留哪些 pillar: first|count|near (默认: first)\n"
+                      << "  --pillar-order <m>    pillar 输出顺序: arrival|row|morton，row 让 scatter 顺序写 (默认: row)\n"
+                      << "  --dynamic-voxel       动态体素化: 点直接进 PFN，不填充、不截断 pillar 点数\n"
+                      << "  --stream-chunks <n>   流式体素化: 点云按文件顺序分 n 块依次送入，报告最后一块之后的耗时\n"
+                      << "                         (动态体素化时 PFN 也随块进行；不支持多帧累积)\n"
+                      << "  --sweep-list <path>   多帧累积: 每行 \"bin 时间戳 4x4位姿\"，最后一行为当前帧\n"
+                      << "  --max-sweeps <int>    多帧累积的帧数上限 (默认: 10)\n";
             return 0;
         }
     }
     
+    if (stream_chunks > 0 && !sweep_list.empty()) {
+        std::cerr << "--stream-chunks 不能与 --sweep-list 同时使用" << std::endl;
+        return 1;
+    }
+    
     std::cout << std::string(80, '=') << std::endl;
     std::cout << "PointPillars 完整推理流程" << std::endl;
     std::cout << std::string(80, '=') << std::endl;
@@ -118,63 +253,195 @@ int main(int argc, char* argv[]) {
     try {
         auto total_start = std::chrono::high_resolution_clock::now();
         
+        DecodeConfig decode_cfg;
+        decode_cfg.num_classes = 3;  // 6 anchors * 3 classes = 18 channels
+        PackedPFNWeights bundle_pfn;
+        if (!bundle_path.empty()) {
+            if (!pfn_bn.empty()) {
+                throw std::invalid_argument("--pfn-bn 不能与 --bundle 同时使用（BN 在打包时折叠）");
+            }
+            auto t0 = std::chrono::high_resolution_clock::now();
+            ModelBundle bundle(bundle_path);
+            voxel_config = bundle.voxel_config(voxel_config);
+            decode_cfg = bundle.decode_config(decode_cfg);
+            bundle_pfn = bundle.pfn_weights();
+            if (!rpn_model_set && !bundle.rpn_model_path().empty()) {
+                rpn_model = bundle.rpn_model_path();
+            }
+            auto t1 = std::chrono::high_resolution_clock::now();
+            std::cout << "模型包: " << bundle_path << " (v" << bundle.version() << ", "
+                      << std::fixed << std::setprecision(2)
+                      << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms)" << std::endl;
+        }
+        
         // === 1. 加载点云 ===
         std::cout << "\n--- 步骤1: 加载点云 ---" << std::endl;
         auto t0 = std::chrono::high_resolution_clock::now();
-        auto points = load_pointcloud(pointcloud_file);
+        std::vector<SweepEntry> sweeps;
+        std::vector<float> points;
+        if (sweep_list.empty()) {
+            points = load_pointcloud(pointcloud_file);
+        } else {
+            sweeps = load_sweep_list(sweep_list);
+            std::cout << "多帧累积: " << sweeps.size() << " 帧" << std::endl;
+        }
         auto t1 = std::chrono::high_resolution_clock::now();
         double load_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
         std::cout << "耗时: " << std::fixed << std::setprecision(2) << load_time << " ms" << std::endl;
         
+        // === 1.5 预过滤（裁剪 + 高度/强度过滤 + 压缩）===
+        std::cout << "\n--- 步骤1.5: 点云预过滤 ---" << std::endl;
+        t0 = std::chrono::high_resolution_clock::now();
+        prefilter_config.crop_range = voxel_config.point_cloud_range;
+        SweepAccumulator accumulator(sweep_config);
+        if (sweeps.empty()) {
+            PointPrefilter prefilter(prefilter_config);
+            points = prefilter.apply(points);
+        } else {
+            // 历史帧在各自的传感器坐标系下，范围裁剪要等变换到当前帧后由体素化完成
+            PrefilterConfig sweep_filter = prefilter_config;
+            sweep_filter.crop_range = {-1e9f, -1e9f, -1e9f, 1e9f, 1e9f, 1e9f};
+            PointPrefilter prefilter(sweep_filter);
+            for (const auto& e : sweeps) {
+                auto sweep_points = prefilter.apply(load_pointcloud(e.path));
+                accumulator.push(sweep_points.data(), sweep_points.size() / 4, e.pose, e.timestamp);
+            }
+        }
+        t1 = std::chrono::high_resolution_clock::now();
+        double prefilter_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        std::cout << "耗时: " << std::fixed << std::setprecision(2) << prefilter_time << " ms" << std::endl;
+        
         // === 2. 体素化 ===
         std::cout << "\n--- 步骤2: 体素化 ---" << std::endl;
         t0 = std::chrono::high_resolution_clock::now();
-        VoxelConfig voxel_config;
-        Voxelizer voxelizer(voxel_config);
-        auto voxel_data = voxelizer.generate(points);
+        VoxelData voxel_data;
+        std::vector<PointSpan> spans;  // 动态体素化时直接交给 PFN
+        if (sweeps.empty()) {
+            spans.push_back({points.data(), points.size() / voxel_config.num_point_features});
+        } else {
+            // 每点 [x, y, z, intensity, 时间差]，各帧直接以 span 形式交给体素化
+            voxel_config.num_point_features = 5;
+            spans = accumulator.accumulate();
+            std::cout << "累积帧数: " << spans.size() << std::endl;
+        }
+        // 流式回放：点云按文件顺序切成 stream_chunks 块，最后一块之前的工作可以与数据包到达重叠
+        auto for_each_chunk = [&](const auto& add) {
+            const size_t num_points = points.size() / voxel_config.num_point_features;
+            for (int c = 0; c < stream_chunks; ++c) {
+                const size_t begin = num_points * c / stream_chunks;
+                const size_t end = num_points * (c + 1) / stream_chunks;
+                add(points.data() + begin * voxel_config.num_point_features, end - begin, c == stream_chunks - 1);
+            }
+        };
+        double stream_tail_ms = 0;  // 最后一块 + 收尾
+        if (dynamic_voxel) {
+            std::cout << "动态体素化: 跳过，点在 PFN 阶段直接映射到 pillar" << std::endl;
+        } else if (stream_chunks > 0) {
+            Voxelizer voxelizer(voxel_config);
+            voxelizer.begin_frame();
+            auto tail_start = t0;
+            for_each_chunk([&](const float* chunk, size_t n, bool last) {
+                if (last) tail_start = std::chrono::high_resolution_clock::now();
+                voxelizer.add_points(chunk, n);
+            });
+            voxel_data = voxelizer.end_frame();
+            stream_tail_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - tail_start).count();
+        } else {
+            Voxelizer voxelizer(voxel_config);
+            voxel_data = voxelizer.generate(spans);
+        }
         t1 = std::chrono::high_resolution_clock::now();
         double voxel_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
         std::cout << "体素数: " << voxel_data.num_voxels << std::endl;
         std::cout << "耗时: " << std::fixed << std::setprecision(2) << voxel_time << " ms" << std::endl;
+        if (stream_chunks > 0 && !dynamic_voxel) {
+            std::cout << "流式: " << stream_chunks << " 块，最后一块 + end_frame " << std::fixed
+                      << std::setprecision(2) << stream_tail_ms << " ms" << std::endl;
+        }
         
         // === 3. 初始化 PFN ===
         std::cout << "\n--- 步骤3: 初始化 PFN (CPU) ---" << std::endl;
         t0 = std::chrono::high_resolution_clock::now();
         PFN_CPU pfn_runner;
-        pfn_runner.pfn_weights = load_bin(pfn_weight.c_str());
-        pfn_runner.pfn_bias = load_bin(pfn_bias.c_str());
+        if (bundle_pfn.point_weights) {
+            pfn_runner.use_packed_weights(bundle_pfn);
+        } else {
+            pfn_runner.pfn_weights = load_bin(pfn_weight.c_str());
+            pfn_runner.pfn_bias = load_bin(pfn_bias.c_str());
+            if (!pfn_bn.empty()) {
+                pfn_runner.fold_batchnorm(load_bin((pfn_bn + "_gamma.bin").c_str()),
+                                          load_bin((pfn_bn + "_beta.bin").c_str()),
+                                          load_bin((pfn_bn + "_mean.bin").c_str()),
+                                          load_bin((pfn_bn + "_var.bin").c_str()));
+                std::cout << "已折叠 PFN BatchNorm: " << pfn_bn << "_*.bin" << std::endl;
+            }
+        }
+        pfn_runner.voxel = voxel_config;
+        std::shared_ptr<RoiMask> roi;
+        if (!roi_polygons.empty()) {
+            roi = std::make_shared<RoiMask>(decode_cfg.grid_x, decode_cfg.grid_y, decode_cfg.x_min,
+                                            decode_cfg.y_min, decode_cfg.voxel_size_x, decode_cfg.voxel_size_y);
+            for (const auto& polygon : roi_polygons) {
+                roi->add_polygon(polygon);
+            }
+            pfn_runner.roi = roi;
+            std::cout << "ROI: " << roi_polygons.size() << " 个多边形, " << roi->num_cells() << " 个 cell" << std::endl;
+        }
         t1 = std::chrono::high_resolution_clock::now();
         double pfn_init_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
-        std::cout << "PFN权重大小: " << pfn_runner.pfn_weights.size() << std::endl;
-        std::cout << "PFN偏置大小: " << pfn_runner.pfn_bias.size() << std::endl;
+        if (bundle_pfn.point_weights) {
+            std::cout << "PFN权重: 模型包预打包 [" << bundle_pfn.num_features << ", "
+                      << bundle_pfn.channels << "]" << std::endl;
+        } else {
+            std::cout << "PFN权重大小: " << pfn_runner.pfn_weights.size() << std::endl;
+            std::cout << "PFN偏置大小: " << pfn_runner.pfn_bias.size() << std::endl;
+        }
         std::cout << "耗时: " << std::fixed << std::setprecision(2) << pfn_init_time << " ms" << std::endl;
         
-        // === 4. PFN 前向 + Scatter ===
-        std::cout << "\n--- 步骤4: PFN 前向 + Scatter ---" << std::endl;
+        // === 4. PFN 前向（稀疏输出）===
+        std::cout << "\n--- 步骤4: PFN 前向 (稀疏) ---" << std::endl;
         t0 = std::chrono::high_resolution_clock::now();
-        std::vector<float> rpn_input_map(1 * 64 * 496 * 432, 0.0f);
         
-        // 转换 VoxelData 到 VoxelInfo
-        VoxelInfo voxel_info;
-        voxel_info.voxels = voxel_data.voxels.data();
-        voxel_info.coordinates = voxel_data.coordinates.data();
-        voxel_info.num_points = voxel_data.num_points.data();
-        voxel_info.num_voxels = voxel_data.num_voxels;
-        voxel_info.max_points = voxel_config.max_num_points;
+        // VoxelInfo 直接引用 VoxelData 的紧凑平面
+        const VoxelInfo voxel_info = make_voxel_info(voxel_data, voxel_config);
         
-        pfn_runner.run(voxel_info, rpn_input_map.data());
+        // 只输出被占用的 pillar：[P, 64] 特征 + [P] cell 索引，scatter 由 RPN 后端完成
+        SparsePillars pillars;
+        if (dynamic_voxel && stream_chunks > 0) {
+            pfn_runner.begin_stream();
+            auto tail_start = t0;
+            for_each_chunk([&](const float* chunk, size_t n, bool last) {
+                if (last) tail_start = std::chrono::high_resolution_clock::now();
+                pfn_runner.add_points(chunk, n);
+            });
+            pfn_runner.end_stream(pillars);
+            stream_tail_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::high_resolution_clock::now() - tail_start).count();
+        } else if (dynamic_voxel) {
+            pfn_runner.run_dynamic({spans}, pillars);
+        } else {
+            pfn_runner.run_sparse(voxel_info, pillars);
+        }
         t1 = std::chrono::high_resolution_clock::now();
         double pfn_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
-        std::cout << "RPN输入形状: [1, 64, 496, 432]" << std::endl;
+        std::cout << "稀疏特征形状: [" << pillars.num_pillars << ", " << pillars.channels << "]"
+                  << " (占用率 " << std::fixed << std::setprecision(2)
+                  << 100.0 * pillars.num_pillars / (pillars.grid_h * pillars.grid_w) << "%)" << std::endl;
         std::cout << "耗时: " << std::fixed << std::setprecision(2) << pfn_time << " ms" << std::endl;
+        if (stream_chunks > 0 && dynamic_voxel) {
+            std::cout << "流式: " << stream_chunks << " 块，最后一块 + end_stream " << std::fixed
+                      << std::setprecision(2) << stream_tail_ms << " ms" << std::endl;
+        }
         
         // === 5. RPN 推理 (NPU) ===
         std::cout << "\n--- 步骤5: RPN 推理 (NPU) ---" << std::endl;
         t0 = std::chrono::high_resolution_clock::now();
         RPNRunner rpn_runner(rpn_model);
-        std::vector<float> box_map(1 * 42 * 496 * 432, 0.0f);   // 6 anchors * 7
-        std::vector<float> score_map(1 * 18 * 496 * 432, 0.0f); // 6 anchors * 3
-        rpn_runner.run(rpn_input_map.data(), box_map.data(), score_map.data());
+        const size_t plane = static_cast<size_t>(KittiPillars::grid_y) * KittiPillars::grid_x;
+        std::vector<float> box_map(KittiPillars::box_channels * plane, 0.0f);     // 6 anchors * 7
+        std::vector<float> score_map(KittiPillars::score_channels * plane, 0.0f); // 6 anchors * 3
+        rpn_runner.run_sparse(pillars, box_map.data(), score_map.data());
         t1 = std::chrono::high_resolution_clock::now();
         double rpn_time = std::chrono::duration<double, std::milli>(t1 - t0).count();
         std::cout << "耗时: " << std::fixed << std::setprecision(2) << rpn_time << " ms" << std::endl;
@@ -225,12 +492,13 @@ int main(int argc, char* argv[]) {
             std::cerr << "  警告: RPN输出值较大，可能影响精度" << std::endl;
         }
         
-        DecodeConfig decode_cfg;
-        decode_cfg.num_classes = 3;  // 6 anchors * 3 classes = 18 channels
         AnchorDecoder decoder(decode_cfg);
         std::cout << "  开始Decode..." << std::endl;
         std::cout.flush();  // 强制刷新输出
-        auto decoded = decoder.decode(box_map.data(), score_map.data(), score_thr);
+        auto decoded = decoder.decode(box_map.data(), score_map.data(), score_thr, rpn_runner.dir_map(), roi.get());
+        if (nms_pre > 0 && decoded.size() > static_cast<size_t>(nms_pre)) {
+            decoded.resize(nms_pre);  // decode 输出已按 score 降序
+        }
         std::cout << "  开始NMS..." << std::endl;
         std::cout.flush();
         auto final_boxes = nms_bev_rotated(decoded, nms_thr, max_num);
@@ -252,9 +520,10 @@ int main(int argc, char* argv[]) {
         std::cout << std::string(80, '=') << std::endl;
         std::cout << std::fixed << std::setprecision(2);
         std::cout << "  加载点云:    " << std::setw(8) << load_time << " ms" << std::endl;
+        std::cout << "  预过滤:      " << std::setw(8) << prefilter_time << " ms" << std::endl;
         std::cout << "  体素化:      " << std::setw(8) << voxel_time << " ms" << std::endl;
         std::cout << "  PFN初始化:   " << std::setw(8) << pfn_init_time << " ms" << std::endl;
-        std::cout << "  PFN+Scatter: " << std::setw(8) << pfn_time << " ms" << std::endl;
+        std::cout << "  PFN(稀疏):   " << std::setw(8) << pfn_time << " ms" << std::endl;
         std::cout << "  RPN推理:     " << std::setw(8) << rpn_time << " ms" << std::endl;
         std::cout << "  Decode+NMS:  " << std::setw(8) << decode_time << " ms" << std::endl;
         std::cout << "  " << std::string(76, '-') << std::endl;
@@ -0,0 +1,287 @@
+#include "model_bundle.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+uint64_t fnv1a64(const uint8_t* data, size_t size) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= data[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+size_t align_up(size_t v) {
+    return (v + kBundleAlignment - 1) / kBundleAlignment * kBundleAlignment;
+}
+
+template <class T>
+T read_pod(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+} // namespace
+
+// ---------------- 写出 ----------------
+
+void write_model_bundle(const std::string& path, const ModelBundleContents& contents) {
+    const auto& pfn = contents.pfn;
+    if (pfn.num_features <= 0 || pfn.channels <= 0 || !pfn.point_weights || !pfn.aug_weights || !pfn.bias) {
+        throw std::invalid_argument("write_model_bundle: PFN 权重不完整");
+    }
+    const size_t C = pfn.channels;
+
+    struct Blob {
+        BundleSection id;
+        std::vector<uint8_t> bytes;
+    };
+    std::vector<Blob> blobs;
+    auto add = [&](BundleSection id, const void* data, size_t size) {
+        const auto* p = static_cast<const uint8_t*>(data);
+        blobs.push_back({id, std::vector<uint8_t>(p, p + size)});
+    };
+
+    const BundlePfnMeta meta = {pfn.num_features, pfn.channels, pfn.center_dims, pfn.relu ? 1 : 0};
+    add(BundleSection::PfnMeta, &meta, sizeof(meta));
+    add(BundleSection::PfnPointWeights, pfn.point_weights, static_cast<size_t>(pfn.num_features) * C * sizeof(float));
+    add(BundleSection::PfnAugWeights, pfn.aug_weights, 6 * C * sizeof(float));
+    add(BundleSection::PfnBias, pfn.bias, C * sizeof(float));
+
+    const auto& vc = contents.voxel;
+    BundleVoxelConfig voxel = {};
+    voxel.num_point_features = vc.num_point_features;
+    voxel.max_num_points = vc.max_num_points;
+    voxel.max_voxels = vc.max_voxels;
+    std::copy(vc.point_cloud_range.begin(), vc.point_cloud_range.end(), voxel.point_cloud_range);
+    std::copy(vc.voxel_size.begin(), vc.voxel_size.end(), voxel.voxel_size);
+    add(BundleSection::Voxel, &voxel, sizeof(voxel));
+
+    const auto& dc = contents.decode;
+    BundleDecodeConfig decode = {};
+    decode.grid_x = dc.grid_x;
+    decode.grid_y = dc.grid_y;
+    decode.num_rot = dc.num_rot;
+    decode.num_classes = dc.num_classes;
+    decode.box_code_size = dc.box_code_size;
+    decode.num_dir_bins = dc.num_dir_bins;
+    decode.num_anchor_sizes = static_cast<int32_t>(dc.anchor_sizes.size());
+    decode.num_rotations = static_cast<int32_t>(dc.rotations.size());
+    decode.voxel_size_x = dc.voxel_size_x;
+    decode.voxel_size_y = dc.voxel_size_y;
+    decode.x_min = dc.x_min;
+    decode.y_min = dc.y_min;
+    decode.dir_offset = dc.dir_offset;
+    decode.dir_limit_offset = dc.dir_limit_offset;
+    add(BundleSection::Decode, &decode, sizeof(decode));
+
+    std::vector<float> anchors;
+    for (const auto& a : dc.anchor_sizes) {
+        anchors.insert(anchors.end(), {a.w, a.l, a.h, a.z_center});
+    }
+    anchors.insert(anchors.end(), dc.rotations.begin(), dc.rotations.end());
+    add(BundleSection::Anchors, anchors.data(), anchors.size() * sizeof(float));
+
+    if (!contents.rpn_model_path.empty()) {
+        add(BundleSection::RpnModelPath, contents.rpn_model_path.data(), contents.rpn_model_path.size());
+    }
+
+    // 布局：header + 段表，之后每段按 64 字节对齐
+    std::vector<BundleSectionEntry> table(blobs.size());
+    size_t offset = align_up(sizeof(BundleHeader) + table.size() * sizeof(BundleSectionEntry));
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        table[i] = {static_cast<uint32_t>(blobs[i].id), 0, offset, blobs[i].bytes.size()};
+        offset = align_up(offset + blobs[i].bytes.size());
+    }
+    std::vector<uint8_t> file(offset, 0);
+    std::memcpy(file.data() + sizeof(BundleHeader), table.data(), table.size() * sizeof(BundleSectionEntry));
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        std::memcpy(file.data() + table[i].offset, blobs[i].bytes.data(), blobs[i].bytes.size());
+    }
+
+    BundleHeader header = {};
+    std::memcpy(header.magic, kBundleMagic, sizeof(header.magic));
+    header.version = kBundleVersion;
+    header.num_sections = static_cast<uint32_t>(table.size());
+    header.file_size = file.size();
+    header.checksum = fnv1a64(file.data() + sizeof(BundleHeader), file.size() - sizeof(BundleHeader));
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("无法写入模型包: " + path);
+    }
+    out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!out) {
+        throw std::runtime_error("写入模型包失败: " + path);
+    }
+}
+
+// ---------------- 读取 ----------------
+
+struct ModelBundle::Mapping {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    const BundleSectionEntry* table = nullptr;
+    uint32_t num_sections = 0;
+
+    ~Mapping() {
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+    }
+};
+
+ModelBundle::ModelBundle(const std::string& path, bool verify_checksum) : path_(path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("无法打开模型包: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BundleHeader)) {
+        ::close(fd);
+        throw std::runtime_error("模型包过小或无法读取: " + path);
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("mmap 模型包失败: " + path);
+    }
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<const uint8_t*>(addr);
+    mapping->size = size;
+
+    const auto header = read_pod<BundleHeader>(mapping->data);
+    if (std::memcmp(header.magic, kBundleMagic, sizeof(kBundleMagic)) != 0) {
+        throw std::runtime_error("不是模型包文件: " + path);
+    }
+    if (header.version != kBundleVersion) {
+        throw std::runtime_error("模型包版本 " + std::to_string(header.version) + " 不受支持（需要 " +
+                                 std::to_string(kBundleVersion) + "）: " + path);
+    }
+    if (header.file_size != size ||
+        sizeof(BundleHeader) + static_cast<size_t>(header.num_sections) * sizeof(BundleSectionEntry) > size) {
+        throw std::runtime_error("模型包被截断: " + path);
+    }
+    if (verify_checksum &&
+        fnv1a64(mapping->data + sizeof(BundleHeader), size - sizeof(BundleHeader)) != header.checksum) {
+        throw std::runtime_error("模型包校验和不匹配: " + path);
+    }
+    mapping->table = reinterpret_cast<const BundleSectionEntry*>(mapping->data + sizeof(BundleHeader));
+    mapping->num_sections = header.num_sections;
+    for (uint32_t i = 0; i < header.num_sections; ++i) {
+        const auto& e = mapping->table[i];
+        if (e.offset % kBundleAlignment != 0 || e.offset > size || e.size > size - e.offset) {
+            throw std::runtime_error("模型包段表损坏: " + path);
+        }
+    }
+    version_ = header.version;
+    mapping_ = std::move(mapping);
+}
+
+const uint8_t* ModelBundle::section(BundleSection id, size_t* size_out) const {
+    for (uint32_t i = 0; i < mapping_->num_sections; ++i) {
+        const auto& e = mapping_->table[i];
+        if (e.id == static_cast<uint32_t>(id)) {
+            if (size_out) {
+                *size_out = e.size;
+            }
+            return mapping_->data + e.offset;
+        }
+    }
+    return nullptr;
+}
+
+const uint8_t* ModelBundle::require(BundleSection id, size_t expected_size) const {
+    size_t size = 0;
+    const uint8_t* p = section(id, &size);
+    if (!p || size != expected_size) {
+        throw std::runtime_error("模型包缺少段 " + std::to_string(static_cast<uint32_t>(id)) +
+                                 " 或大小不符: " + path_);
+    }
+    return p;
+}
+
+PackedPFNWeights ModelBundle::pfn_weights() const {
+    const auto meta = read_pod<BundlePfnMeta>(require(BundleSection::PfnMeta, sizeof(BundlePfnMeta)));
+    if (meta.num_features <= 0 || meta.channels <= 0) {
+        throw std::runtime_error("模型包 PFN 维度无效: " + path_);
+    }
+    const size_t C = meta.channels;
+    PackedPFNWeights w;
+    w.num_features = meta.num_features;
+    w.channels = meta.channels;
+    w.center_dims = meta.center_dims;
+    w.relu = meta.relu != 0;
+    // 段起始 64 字节对齐，直接按 float 读取
+    w.point_weights = reinterpret_cast<const float*>(
+        require(BundleSection::PfnPointWeights, static_cast<size_t>(meta.num_features) * C * sizeof(float)));
+    w.aug_weights = reinterpret_cast<const float*>(require(BundleSection::PfnAugWeights, 6 * C * sizeof(float)));
+    w.bias = reinterpret_cast<const float*>(require(BundleSection::PfnBias, C * sizeof(float)));
+    w.owner = mapping_;
+    return w;
+}
+
+VoxelConfig ModelBundle::voxel_config(VoxelConfig base) const {
+    const auto v = read_pod<BundleVoxelConfig>(require(BundleSection::Voxel, sizeof(BundleVoxelConfig)));
+    base.num_point_features = v.num_point_features;
+    base.max_num_points = v.max_num_points;
+    base.max_voxels = v.max_voxels;
+    std::copy(v.point_cloud_range, v.point_cloud_range + 6, base.point_cloud_range.begin());
+    std::copy(v.voxel_size, v.voxel_size + 3, base.voxel_size.begin());
+    return base;
+}
+
+DecodeConfig ModelBundle::decode_config(DecodeConfig base) const {
+    const auto d = read_pod<BundleDecodeConfig>(require(BundleSection::Decode, sizeof(BundleDecodeConfig)));
+    if (d.num_anchor_sizes < 0 || d.num_rotations < 0) {
+        throw std::runtime_error("模型包 decode 配置无效: " + path_);
+    }
+    base.grid_x = d.grid_x;
+    base.grid_y = d.grid_y;
+    base.num_rot = d.num_rot;
+    base.num_classes = d.num_classes;
+    base.box_code_size = d.box_code_size;
+    base.num_dir_bins = d.num_dir_bins;
+    base.voxel_size_x = d.voxel_size_x;
+    base.voxel_size_y = d.voxel_size_y;
+    base.x_min = d.x_min;
+    base.y_min = d.y_min;
+    base.dir_offset = d.dir_offset;
+    base.dir_limit_offset = d.dir_limit_offset;
+
+    const size_t num_floats = static_cast<size_t>(d.num_anchor_sizes) * 4 + d.num_rotations;
+    const auto* a = reinterpret_cast<const float*>(require(BundleSection::Anchors, num_floats * sizeof(float)));
+    base.anchor_sizes.clear();
+    for (int i = 0; i < d.num_anchor_sizes; ++i, a += 4) {
+        base.anchor_sizes.push_back({a[0], a[1], a[2], a[3]});
+    }
+    base.rotations.assign(a, a + d.num_rotations);
+    return base;
+}
+
+std::string ModelBundle::rpn_model_path() const {
+    size_t size = 0;
+    const uint8_t* p = section(BundleSection::RpnModelPath, &size);
+    if (!p) {
+        return {};
+    }
+    std::filesystem::path model(std::string(reinterpret_cast<const char*>(p), size));
+    if (model.is_relative()) {
+        model = std::filesystem::path(path_).parent_path() / model;
+    }
+    return model.string();
+}
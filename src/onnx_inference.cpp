@@ -20,7 +20,8 @@ std::string PythonInference::get_script_dir() const {
     return ".";
 }
 
-std::string PythonInference::write_temp_file(const std::string& prefix, const std::vector<float>& data) {
+template <typename T>
+std::string PythonInference::write_temp_file(const std::string& prefix, const std::vector<T>& data) {
     auto now = std::chrono::high_resolution_clock::now();
     auto duration = now.time_since_epoch();
     auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
@@ -30,31 +31,12 @@ std::string PythonInference::write_temp_file(const std::string& prefix, const st
     if (!file) {
         throw std::runtime_error("Failed to create temp file: " + filename);
     }
-    file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
     file.close();
     return filename;
 }
 
-std::string PythonInference::write_temp_file(const std::string& prefix, const std::vector<int>& data) {
-    auto now = std::chrono::high_resolution_clock::now();
-    auto duration = now.time_since_epoch();
-    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
-    
-    std::string filename = "/tmp/" + prefix + "_" + std::to_string(micros) + ".bin";
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Failed to create temp file: " + filename);
-    }
-    file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(int));
-    file.close();
-    return filename;
-}
-
-InferenceOutput PythonInference::run(
-    const std::vector<float>& voxels,
-    const std::vector<int>& coordinates,
-    const std::vector<int>& num_points,
-    int num_voxels) {
+InferenceOutput PythonInference::run(const VoxelData& voxel_data, const VoxelConfig& config) {
     
     std::cout << "Running Python inference..." << std::endl;
     
@@ -62,17 +44,23 @@ InferenceOutput PythonInference::run(
     
     try {
         // Write temporary files
-        std::string voxels_file = write_temp_file("voxels", voxels);
-        std::string coors_file = write_temp_file("coors", coordinates);
-        std::string num_pts_file = write_temp_file("num_points", num_points);
+        std::string voxels_file = write_temp_file("voxels", voxel_data.voxels);
+        std::string coor_x_file = write_temp_file("coor_x", voxel_data.coor_x);
+        std::string coor_y_file = write_temp_file("coor_y", voxel_data.coor_y);
+        std::string batch_file = write_temp_file("batch_ids", voxel_data.batch_ids);
+        std::string num_pts_file = write_temp_file("num_points", voxel_data.num_points);
         
         // Build Python command
         std::string script_dir = get_script_dir();
         std::string cmd = "python " + script_dir + "/inference_service.py"
             " --onnx-model " + model_path_ +
             " --voxels " + voxels_file +
-            " --coors " + coors_file +
-            " --num-points " + num_pts_file;
+            " --coor-x " + coor_x_file +
+            " --coor-y " + coor_y_file +
+            " --batch-ids " + batch_file +
+            " --num-points " + num_pts_file +
+            " --max-points " + std::to_string(config.max_num_points) +
+            " --num-features " + std::to_string(config.num_point_features);
         
         std::cout << "  Executing: " << cmd << std::endl;
         
@@ -161,7 +149,9 @@ InferenceOutput PythonInference::run(
         
         // Clean up temp files
         std::remove(voxels_file.c_str());
-        std::remove(coors_file.c_str());
+        std::remove(coor_x_file.c_str());
+        std::remove(coor_y_file.c_str());
+        std::remove(batch_file.c_str());
         std::remove(num_pts_file.c_str());
         
     } catch (const std::exception& e) {
@@ -1,105 +1,605 @@
 #include "pfn.hpp"
+#include "pillar_config.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
+void scatter_sparse_to_dense(
+    const SparsePillars& sparse,
+    float* rpn_input_map,
+    const std::vector<int32_t>* prev_cells) {
+    const int C = sparse.channels;
+    const size_t plane = static_cast<size_t>(sparse.grid_h) * sparse.grid_w;
+
+    // NCHW layout: [batch][channel][y][x]，cell = (batch * H + y) * W + x
+    // cell 在 map 中第 0 通道的偏移：batch * C * plane + (cell - batch * plane)
+    auto cell_offset = [&](int32_t cell) {
+        const size_t batch = cell / plane;
+        return batch * (C - 1) * plane + cell;
+    };
+
+    // 按通道外层、pillar 内层写：每个通道平面内的写入顺序跟 pillar 顺序一致，
+    // pillar 按 cell 排序（VoxelConfig::order = RowMajor）时是单调递增的流式写
+    if (prev_cells) {
+        // 只清零上一帧写过的 cell，其余位置本来就是 0
+        std::vector<size_t> prev_offsets(prev_cells->size());
+        for (size_t i = 0; i < prev_cells->size(); ++i) {
+            prev_offsets[i] = cell_offset((*prev_cells)[i]);
+        }
+        for (int c = 0; c < C; ++c) {
+            float* dst = rpn_input_map + c * plane;
+            for (size_t off : prev_offsets) {
+                dst[off] = 0.0f;
+            }
+        }
+    } else {
+        std::memset(rpn_input_map, 0, sparse.batch_size * C * plane * sizeof(float));
+    }
+
+    const int P = sparse.num_pillars;
+    std::vector<size_t> offsets(P);
+    for (int p = 0; p < P; ++p) {
+        offsets[p] = cell_offset(sparse.cell_indices[p]);
+    }
+    for (int c = 0; c < C; ++c) {
+        float* dst = rpn_input_map + c * plane;
+        const float* src = sparse.features.data() + c;
+        for (int p = 0; p < P; ++p) {
+            dst[offsets[p]] = src[static_cast<size_t>(p) * C];
+        }
+    }
+}
+
+void scatter_pillar_delta(const SparsePillars& sparse, float* rpn_input_map) {
+    const int C = sparse.channels;
+    const size_t plane = static_cast<size_t>(sparse.grid_h) * sparse.grid_w;
+    auto cell_base = [&](int32_t cell) {
+        const size_t batch = cell / plane;
+        return rpn_input_map + batch * (C - 1) * plane + cell;
+    };
+
+    for (int32_t cell : sparse.removed_cells) {
+        float* dst = cell_base(cell);
+        for (int c = 0; c < C; ++c) {
+            dst[c * plane] = 0.0f;
+        }
+    }
+    for (int32_t row : sparse.changed_rows) {
+        const float* feature = sparse.features.data() + static_cast<size_t>(row) * C;
+        float* dst = cell_base(sparse.cell_indices[row]);
+        for (int c = 0; c < C; ++c) {
+            dst[c * plane] = feature[c];
+        }
+    }
+}
+
+namespace {
+
+// SparsePillars::frame 的来源：所有 PFN_CPU 实例共用，帧号全局唯一，
+// 消费方只凭帧号就能判断手里的稠密输入是不是增量的基准帧
+std::atomic<uint64_t> next_cache_frame{1};
+
+// splitmix64 的混合函数
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// 单点线性变换（不含 bias），按通道 max 进 best。
+// StaticDims 时 C 个累加器在栈上，编译器可以按通道展开 / 向量化；
+// RuntimeDims 按通道逐个累加，两者的累加顺序相同，结果逐位一致
+template <class Dims>
+inline void pfn_point_max(const Dims& dims, const float* pt, const float* weights, float* best) {
+    if constexpr (std::is_same_v<Dims, RuntimeDims>) {
+        const int F = dims.point_features();
+        const int C = dims.channels();
+        for (int o = 0; o < C; ++o) {
+            float sum = 0.0f;
+            for (int i = 0; i < F; ++i) sum += pt[i] * weights[i * C + o];
+            best[o] = std::max(best[o], sum);
+        }
+    } else {
+        constexpr int F = Dims::point_features();
+        constexpr int C = Dims::channels();
+        float sum[C];
+        for (int o = 0; o < C; ++o) sum[o] = 0.0f;
+        for (int i = 0; i < F; ++i) {
+            const float v = pt[i];
+            const float* w = weights + i * C;
+            for (int o = 0; o < C; ++o) sum[o] += v * w[o];
+        }
+        for (int o = 0; o < C; ++o) best[o] = std::max(best[o], sum[o]);
+    }
+}
+
+} // namespace
+
+uint64_t PFN_CPU::pillar_hash(const float* voxel_points, int num_pts, int num_features) const {
+    // 每个点单独哈希后求和，与点在 pillar 中的顺序无关
+    uint64_t sum = mix64(static_cast<uint64_t>(num_pts));
+    for (int p = 0; p < num_pts; ++p) {
+        const float* pt = voxel_points + p * num_features;
+        uint64_t h = 0;
+        for (int f = 0; f < num_features; ++f) {
+            const int64_t q = static_cast<int64_t>(std::lrint(pt[f] * cache_inv_step_));
+            h = mix64(h ^ static_cast<uint64_t>(q));
+        }
+        sum += h;
+    }
+    return sum;
+}
+
+void PFN_CPU::enable_cache(float quant_step) {
+    if (!(quant_step > 0.0f)) {
+        throw std::invalid_argument("PFN_CPU: cache quant_step must be > 0");
+    }
+    cache_enabled_ = true;
+    cache_inv_step_ = 1.0f / quant_step;
+    reset_cache();
+}
+
+void PFN_CPU::disable_cache() {
+    cache_enabled_ = false;
+    reset_cache();
+}
+
+void PFN_CPU::reset_cache() {
+    cache_states_.clear();
+    cache_stats_ = PillarCacheStats();
+    incremental_map_ = nullptr;
+}
+
+void PFN_CPU::update_cache(CacheState& state, SparsePillars& out) {
+    // 找出消失的 cell，并把行号表切换到当前帧
+    out.removed_cells.clear();
+    for (size_t r = 0; r < state.cells.size(); ++r) {
+        if (!prev_present_[r]) {
+            out.removed_cells.push_back(state.cells[r]);
+        }
+        state.cell_row[state.cells[r]] = -1;
+    }
+    for (int p = 0; p < out.num_pillars; ++p) {
+        state.cell_row[out.cell_indices[p]] = p;
+    }
+    state.cells.assign(out.cell_indices.begin(), out.cell_indices.begin() + out.num_pillars);
+    state.hashes.assign(frame_hashes_.begin(), frame_hashes_.begin() + out.num_pillars);
+    state.features.assign(out.features.begin(),
+                          out.features.begin() + static_cast<size_t>(out.num_pillars) * out.channels);
+    out.base_frame = state.frame;
+    out.frame = next_cache_frame++;
+    state.frame = out.frame;
+
+    cache_stats_.last_pillars = out.num_pillars;
+    cache_stats_.last_changed = static_cast<int>(out.changed_rows.size());
+    cache_stats_.last_removed = static_cast<int>(out.removed_cells.size());
+}
+
+void PFN_CPU::prepare_weights(int num_features) {
+    if (external_weights_) {
+        if (num_features != packed_.num_features) {
+            throw std::runtime_error("PFN packed weights expect " + std::to_string(packed_.num_features) +
+                                     " point features, got " + std::to_string(num_features));
+        }
+        return;
+    }
+    const size_t C = pfn_bias.size();
+    if (C == 0 || pfn_weights.size() % C != 0) {
+        throw std::runtime_error("PFN weights size mismatch: " + std::to_string(pfn_weights.size()) +
+                                 " is not a multiple of bias size " + std::to_string(C));
+    }
+    const int F = num_features;
+    const int input_dim = static_cast<int>(pfn_weights.size() / C);
+    const int center_dims = input_dim == F + 6 ? 3 : (input_dim == F + 5 ? 2 : 0);
+
+    point_weights_.assign(static_cast<size_t>(F) * C, 0.0f);
+    std::copy(pfn_weights.begin(), pfn_weights.begin() + static_cast<size_t>(std::min(F, input_dim)) * C,
+              point_weights_.begin());
+    aug_weights_.assign(6 * C, 0.0f);
+    if (center_dims > 0) {
+        // f_cluster = xyz - mean, f_center = xyz - center：xyz 部分并进每点权重，其余是 pillar 常数
+        for (int k = 0; k < 3 + center_dims; ++k) {
+            const float* w = pfn_weights.data() + static_cast<size_t>(F + k) * C;
+            std::copy(w, w + C, aug_weights_.begin() + static_cast<size_t>(k) * C);
+            float* dst = point_weights_.data() + static_cast<size_t>(k % 3) * C;
+            for (size_t o = 0; o < C; ++o) dst[o] += w[o];
+        }
+    }
+
+    packed_.num_features = F;
+    packed_.channels = static_cast<int>(C);
+    packed_.center_dims = center_dims;
+    packed_.relu = relu;
+    packed_.point_weights = point_weights_.data();
+    packed_.aug_weights = aug_weights_.data();
+    packed_.bias = pfn_bias.data();
+    packed_.owner.reset();
+}
+
+const RoiMask* PFN_CPU::checked_roi() const {
+    if (roi && (roi->grid_x() != grid_w || roi->grid_y() != grid_h)) {
+        throw std::invalid_argument("PFN_CPU: ROI grid does not match grid_w / grid_h");
+    }
+    return roi.get();
+}
+
+void PFN_CPU::use_packed_weights(PackedPFNWeights packed) {
+    if (packed.num_features <= 0 || packed.channels <= 0 || !packed.point_weights ||
+        !packed.aug_weights || !packed.bias) {
+        throw std::invalid_argument("PFN packed weights are incomplete");
+    }
+    relu = packed.relu;
+    packed_ = std::move(packed);
+    external_weights_ = true;
+    reset_cache();
+}
+
+PackedPFNWeights PFN_CPU::packed_weights(int num_features) {
+    prepare_weights(num_features);
+    return packed_;
+}
+
+void PFN_CPU::fold_batchnorm(const std::vector<float>& gamma, const std::vector<float>& beta,
+                             const std::vector<float>& mean, const std::vector<float>& var,
+                             float eps) {
+    if (external_weights_) {
+        throw std::runtime_error("PFN BatchNorm cannot be folded into packed weights; fold it when packing");
+    }
+    const size_t C = gamma.size();
+    if (C == 0 || beta.size() != C || mean.size() != C || var.size() != C) {
+        throw std::runtime_error("PFN BatchNorm size mismatch: gamma " + std::to_string(gamma.size()) +
+                                 ", beta " + std::to_string(beta.size()) +
+                                 ", mean " + std::to_string(mean.size()) +
+                                 ", var " + std::to_string(var.size()));
+    }
+    if (pfn_bias.empty()) {
+        pfn_bias.assign(C, 0.0f);
+    }
+    if (pfn_bias.size() != C || pfn_weights.size() % C != 0) {
+        throw std::runtime_error("PFN BatchNorm channels " + std::to_string(C) +
+                                 " do not match weights " + std::to_string(pfn_weights.size()) +
+                                 " / bias " + std::to_string(pfn_bias.size()));
+    }
+    std::vector<float> scale(C);
+    for (size_t o = 0; o < C; ++o) {
+        if (!(var[o] + eps > 0.0f)) {
+            throw std::runtime_error("PFN BatchNorm variance must be positive (channel " +
+                                     std::to_string(o) + ")");
+        }
+        scale[o] = gamma[o] / std::sqrt(var[o] + eps);
+        pfn_bias[o] = (pfn_bias[o] - mean[o]) * scale[o] + beta[o];
+    }
+    // 权重按 [input_dim, C] 行主序，每行逐通道缩放
+    for (size_t i = 0; i < pfn_weights.size(); i += C) {
+        for (size_t o = 0; o < C; ++o) pfn_weights[i + o] *= scale[o];
+    }
+    relu = true;
+    reset_cache();
+}
+
+void PFN_CPU::finish_pillar(const float* xyz_sum, int num_pts, int x, int y, int channels,
+                            bool padded, float* feature) const {
+    const float* bias = packed_.bias;
+    if (packed_.center_dims == 0) {
+        for (int o = 0; o < channels; ++o) feature[o] += bias[o];
+    } else {
+        const float inv = num_pts > 0 ? 1.0f / num_pts : 0.0f;
+        const float mean[3] = {xyz_sum[0] * inv, xyz_sum[1] * inv, xyz_sum[2] * inv};
+        // pillar 中心同 mmdet3d：coord * voxel_size + (voxel_size / 2 + range_min)，pillar 的 z 坐标恒为 0
+        const auto& vs = voxel.voxel_size;
+        const auto& r = voxel.point_cloud_range;
+        const float center[3] = {x * vs[0] + (vs[0] / 2 + r[0]),
+                                 y * vs[1] + (vs[1] / 2 + r[1]),
+                                 packed_.center_dims == 3 ? vs[2] / 2 + r[2] : 0.0f};
+        const float* wm = packed_.aug_weights;
+        const float* wc = packed_.aug_weights + 3 * channels;
+        for (int o = 0; o < channels; ++o) {
+            const float m = wm[o] * mean[0] + wm[channels + o] * mean[1] + wm[2 * channels + o] * mean[2];
+            const float c = wc[o] * center[0] + wc[channels + o] * center[1] + wc[2 * channels + o] * center[2];
+            feature[o] += bias[o] - m - c;
+        }
+    }
+    // 填充行在增广后被清零（mmdet3d PillarFeatureNet / OpenPCDet PillarVFE），线性层输出恰好是 bias，
+    // 和真实点一起参与 max
+    if (padded) {
+        for (int o = 0; o < channels; ++o) feature[o] = std::max(feature[o], bias[o]);
+    }
+    // 常数项对同一 pillar 的所有点相同，max 与其交换；ReLU 单调，同样可以放到 max 之后
+    if (packed_.relu) {
+        for (int o = 0; o < channels; ++o) feature[o] = std::max(feature[o], 0.0f);
+    }
+}
+
+template <class Dims>
 void PFN_CPU::process_voxel(
+    const Dims& dims,
     const float* voxel_points,
     int num_pts,
-    float* output_feature) {
-    
-    // 从权重大小推断维度
-    const size_t output_dim = pfn_bias.size();
-    const size_t input_dim = pfn_weights.size() / output_dim;
-    
-    if (pfn_weights.size() != input_dim * output_dim) {
-        throw std::runtime_error("PFN weights size mismatch: expected " + 
-                                 std::to_string(input_dim * output_dim) + 
-                                 ", got " + std::to_string(pfn_weights.size()));
-    }
-    if (pfn_bias.size() != output_dim) {
-        throw std::runtime_error("PFN bias size mismatch: expected " + 
-                                 std::to_string(output_dim) + 
-                                 ", got " + std::to_string(pfn_bias.size()));
-    }
-    
-    // 检查输入点特征维度是否匹配
-    // 注意：voxel_points 的每个点可能有 input_dim 维，但 Voxelizer 只输出 4 维
-    // 如果 input_dim > 4，需要在这里做特征扩展（归一化坐标等）
-    
+    int max_points,
+    int x, int y,
+    float* output_feature) const {
+    const int F = dims.point_features();
+    const int C = dims.channels();
     // 初始化输出为负无穷（用于 max pooling）
-    std::fill(output_feature, output_feature + output_dim, -1e9f);
-    
-    // 对每个点做线性变换：output = max(weight @ point + bias)
+    std::fill(output_feature, output_feature + C, -1e9f);
+    float xyz_sum[3] = {0.0f, 0.0f, 0.0f};
     for (int p = 0; p < num_pts; ++p) {
-        const float* raw_point = voxel_points + p * 4;  // Voxelizer 输出: [x, y, z, intensity]
-        
-        // 如果 input_dim > 4，需要扩展特征（例如添加归一化坐标）
-        // PointPillars 通常的扩展方式：
-        // [x, y, z, intensity, x_norm, y_norm, z_norm, ...]
-        std::vector<float> point_feature(input_dim, 0.0f);
-        
-        if (input_dim >= 4) {
-            // 前4维：原始特征
-            point_feature[0] = raw_point[0];  // x
-            point_feature[1] = raw_point[1];  // y
-            point_feature[2] = raw_point[2];  // z
-            point_feature[3] = raw_point[3];  // intensity
-        }
-        
-        // 如果 input_dim > 4，添加归一化坐标（相对于 voxel 中心）
-        // 这里简化处理：如果 input_dim=10，可能是 [x,y,z,intensity, x_norm,y_norm,z_norm, x^2,y^2,z^2]
-        // 但为了简化，我们先用零填充，你可以根据实际训练时的特征工程调整
-        // TODO: 根据实际 PFN 输入特征格式调整这里
-        
-        // GEMM: output = point_feature @ weight^T + bias
-        for (size_t o = 0; o < output_dim; ++o) {
-            float sum = pfn_bias[o];
-            for (size_t i = 0; i < input_dim; ++i) {
-                sum += point_feature[i] * pfn_weights[i * output_dim + o];
+        const float* pt = voxel_points + p * F;  // Voxelizer 输出: [x, y, z, intensity, (dt)]
+        xyz_sum[0] += pt[0];
+        xyz_sum[1] += pt[1];
+        xyz_sum[2] += pt[2];
+        pfn_point_max(dims, pt, packed_.point_weights, output_feature);
+    }
+    finish_pillar(xyz_sum, num_pts, x, y, C, num_pts < max_points, output_feature);
+}
+
+void PFN_CPU::run_sparse(const VoxelInfo& voxel_data, SparsePillars& out) {
+    prepare_weights(voxel_data.num_features);
+    RuntimeDims dims;
+    dims.point_features_ = voxel_data.num_features;
+    dims.channels_ = packed_.channels;
+    dispatch_dims(dims, [&](const auto& d) { run_sparse_impl(d, voxel_data, out); });
+}
+
+template <class Dims>
+void PFN_CPU::run_sparse_impl(const Dims& dims, const VoxelInfo& voxel_data, SparsePillars& out) {
+    // RPN 输入尺寸: [N, C, grid_h, grid_w] NCHW
+    const int C = dims.channels();
+    const int H = grid_h;
+    const int W = grid_w;
+
+    out.batch_size = voxel_data.batch_size;
+    out.channels = C;
+    out.grid_h = H;
+    out.grid_w = W;
+    out.features.resize(static_cast<size_t>(voxel_data.num_voxels) * C);
+    out.cell_indices.resize(voxel_data.num_voxels);
+    const RoiMask* roi_mask = checked_roi();
+    out.frame = 0;
+    out.base_frame = 0;
+    out.changed_rows.clear();
+    out.removed_cells.clear();
+
+    CacheState* cache = cache_enabled_ ? &cache_states_[cache_key_] : nullptr;
+    if (cache) {
+        const size_t num_cells = static_cast<size_t>(voxel_data.batch_size) * H * W;
+        if (cache->cell_row.size() < num_cells) {
+            cache->cell_row.resize(num_cells, -1);
+        }
+        frame_hashes_.resize(voxel_data.num_voxels);
+        prev_present_.assign(cache->cells.size(), 0);
+    }
+
+    auto compute = [&](const float* voxel_pts, int num_pts, int x, int y, float* feature) {
+        process_voxel(dims, voxel_pts, num_pts, voxel_data.max_points, x, y, feature);
+    };
+
+    int p = 0;
+    for (int v = 0; v < voxel_data.num_voxels; ++v) {
+        // 获取该 voxel 的 BEV 坐标（pillar 没有 z）
+        const int batch = voxel_data.batch_ids ? voxel_data.batch_ids[v] : 0;
+        const int y = voxel_data.coor_y[v];
+        const int x = voxel_data.coor_x[v];
+
+        // 检查坐标范围（无符号类型，下界恒成立）
+        if (batch >= voxel_data.batch_size || y >= H || x >= W || (roi_mask && !roi_mask->contains(x, y))) {
+            continue;
+        }
+
+        // 处理该 voxel，直接写到第 p 行
+        const float* voxel_pts = voxel_data.voxels + static_cast<size_t>(v) * voxel_data.max_points * dims.point_features();
+        const int num_pts = voxel_data.num_points[v];
+
+        const int32_t cell = (batch * H + y) * W + x;
+        float* feature = out.features.data() + static_cast<size_t>(p) * C;
+
+        if (cache) {
+            const uint64_t hash = pillar_hash(voxel_pts, num_pts, voxel_data.num_features);
+            const int32_t row = cache->cell_row[cell];
+            frame_hashes_[p] = hash;
+            ++cache_stats_.lookups;
+            if (row >= 0) {
+                prev_present_[row] = 1;
             }
-            // Max pooling across points
-            output_feature[o] = std::max(output_feature[o], sum);
+            if (row >= 0 && cache->hashes[row] == hash) {
+                std::memcpy(feature, cache->features.data() + static_cast<size_t>(row) * C, C * sizeof(float));
+                ++cache_stats_.hits;
+            } else {
+                compute(voxel_pts, num_pts, x, y, feature);
+                out.changed_rows.push_back(p);
+            }
+        } else {
+            compute(voxel_pts, num_pts, x, y, feature);
         }
+        out.cell_indices[p] = cell;
+        ++p;
+    }
+
+    out.num_pillars = p;
+    out.features.resize(static_cast<size_t>(p) * C);
+    out.cell_indices.resize(p);
+
+    if (cache) {
+        update_cache(*cache, out);
     }
 }
 
-void PFN_CPU::run(const VoxelInfo& voxel_data, float* rpn_input_map) {
-    // RPN 输入尺寸: [1, 64, 496, 432] NCHW
-    const int N = 1;
-    const int C = 64;
-    const int H = 496;
-    const int W = 432;
-    
-    // 清零 BEV map
-    std::memset(rpn_input_map, 0, N * C * H * W * sizeof(float));
-    
-    // 处理每个 voxel
-    for (int v = 0; v < voxel_data.num_voxels; ++v) {
-        // 获取该 voxel 的坐标 (batch, z, y, x)
-        const int* coords = voxel_data.coordinates + v * 4;
-        int batch = coords[0];
-        // int z = coords[1];  // z 维度在 BEV 中被压缩了，不需要
-        int y = coords[2];
-        int x = coords[3];
-        
-        // 检查坐标范围
-        if (y < 0 || y >= H || x < 0 || x >= W) {
+void PFN_CPU::run_dynamic(const std::vector<std::vector<PointSpan>>& frames, SparsePillars& out) {
+    if (cache_enabled_) {
+        throw std::logic_error("PFN_CPU::run_dynamic does not support the pillar cache");
+    }
+    if (stream_active_) {
+        throw std::logic_error("PFN_CPU::run_dynamic called between begin_stream() and end_stream()");
+    }
+    if (voxel.num_point_features < 3) {
+        throw std::invalid_argument("PFN_CPU: voxel.num_point_features must be >= 3");
+    }
+    prepare_weights(voxel.num_point_features);
+    RuntimeDims dims;
+    dims.point_features_ = voxel.num_point_features;
+    dims.channels_ = packed_.channels;
+    dispatch_dims(dims, [&](const auto& d) { run_dynamic_impl(d, frames, out); });
+}
+
+template <class Dims>
+void PFN_CPU::run_dynamic_impl(const Dims& dims, const std::vector<std::vector<PointSpan>>& frames,
+                               SparsePillars& out) {
+    begin_dynamic(dims.channels(), static_cast<int>(frames.size()), out);
+    const RoiMask* roi_mask = checked_roi();
+
+    for (size_t b = 0; b < frames.size(); ++b) {
+        const int first = out.num_pillars;
+        const int32_t batch_base = static_cast<int32_t>(b) * grid_h * grid_w;
+        for (const auto& span : frames[b]) {
+            accumulate_dynamic(dims, span.data, span.num_points, first, batch_base, roi_mask, out);
+        }
+        finish_dynamic(first, batch_base, out);
+    }
+}
+
+void PFN_CPU::begin_dynamic(int channels, int batch_size, SparsePillars& out) {
+    out.batch_size = batch_size;
+    out.channels = channels;
+    out.grid_h = grid_h;
+    out.grid_w = grid_w;
+    out.num_pillars = 0;
+    out.features.clear();
+    out.cell_indices.clear();
+    out.frame = 0;
+    out.base_frame = 0;
+    out.changed_rows.clear();
+    out.removed_cells.clear();
+    dyn_sums_.clear();
+    dyn_counts_.clear();
+    if (dyn_cell_row_.size() != static_cast<size_t>(grid_h) * grid_w) {
+        dyn_cell_row_.assign(static_cast<size_t>(grid_h) * grid_w, -1);
+    }
+}
+
+template <class Dims>
+void PFN_CPU::accumulate_dynamic(const Dims& dims, const float* points, size_t num_points, int first,
+                                 int32_t batch_base, const RoiMask* roi_mask, SparsePillars& out) {
+    const int F = dims.point_features();
+    const int C = dims.channels();
+    const int H = grid_h;
+    const int W = grid_w;
+    const auto& r = voxel.point_cloud_range;
+    const auto& vs = voxel.voxel_size;
+
+    // 单遍：点 -> cell（首次出现时分配一行），xyz 求和，线性变换后 max 进该行
+    int p = out.num_pillars;
+    for (size_t s = 0; s < num_points; ++s) {
+        const float* pt = points + s * F;
+        const float x = pt[0], y = pt[1], z = pt[2];
+        // 与 Voxelizer 相同的范围判断；写成取反形式同时丢掉 NaN
+        if (!(x >= r[0] && x < r[3] && y >= r[1] && y < r[4] && z >= r[2] && z < r[5])) {
             continue;
         }
-        
-        // 处理该 voxel，得到 64 维特征
-        float feature[64];
-        const float* voxel_pts = voxel_data.voxels + v * voxel_data.max_points * 4;
-        int num_pts = voxel_data.num_points[v];
-        
-        process_voxel(voxel_pts, num_pts, feature);
-        
-        // Scatter: 直接赋值到 BEV grid (不是 max)
-        // NCHW layout: [batch][channel][y][x]
-        for (int c = 0; c < C; ++c) {
-            int idx = batch * (C * H * W) + c * (H * W) + y * W + x;
-            rpn_input_map[idx] = feature[c];
+        const int cx = static_cast<int>((x - r[0]) / vs[0]);
+        const int cy = static_cast<int>((y - r[1]) / vs[1]);
+        if (cx >= W || cy >= H || (roi_mask && !roi_mask->contains(cx, cy))) {
+            continue;
+        }
+        int32_t& row = dyn_cell_row_[static_cast<size_t>(cy) * W + cx];
+        if (row < 0) {
+            if (p - first >= voxel.max_voxels) {
+                continue;
+            }
+            row = p++;
+            out.cell_indices.push_back(batch_base + cy * W + cx);
+            out.features.resize(static_cast<size_t>(p) * C, -1e9f);
+            dyn_sums_.resize(static_cast<size_t>(p) * 3, 0.0f);
+            dyn_counts_.push_back(0);
+        }
+        float* sum = dyn_sums_.data() + static_cast<size_t>(row) * 3;
+        sum[0] += x;
+        sum[1] += y;
+        sum[2] += z;
+        ++dyn_counts_[row];
+        pfn_point_max(dims, pt, packed_.point_weights, out.features.data() + static_cast<size_t>(row) * C);
+    }
+    out.num_pillars = p;
+}
+
+void PFN_CPU::finish_dynamic(int first, int32_t batch_base, SparsePillars& out) {
+    // 加上 pillar 常数项，并只复位本帧用到的 cell
+    const int C = out.channels;
+    for (int row = first; row < out.num_pillars; ++row) {
+        const int32_t cell = out.cell_indices[row] - batch_base;
+        finish_pillar(dyn_sums_.data() + static_cast<size_t>(row) * 3, dyn_counts_[row],
+                      cell % grid_w, cell / grid_w, C, false, out.features.data() + static_cast<size_t>(row) * C);
+        dyn_cell_row_[cell] = -1;
+    }
+}
+
+void PFN_CPU::begin_stream() {
+    if (cache_enabled_) {
+        throw std::logic_error("PFN_CPU streaming does not support the pillar cache");
+    }
+    if (voxel.num_point_features < 3) {
+        throw std::invalid_argument("PFN_CPU: voxel.num_point_features must be >= 3");
+    }
+    // 上一帧没有 end_stream 就放弃了：复位它占用的 cell
+    if (stream_active_) {
+        for (int row = 0; row < stream_.num_pillars; ++row) {
+            dyn_cell_row_[stream_.cell_indices[row]] = -1;
         }
     }
+    prepare_weights(voxel.num_point_features);
+    begin_dynamic(packed_.channels, 1, stream_);
+    checked_roi();
+    stream_roi_ = roi;
+    stream_active_ = true;
+}
+
+void PFN_CPU::add_points(const float* points, size_t num_points) {
+    if (!stream_active_) {
+        throw std::logic_error("PFN_CPU::add_points called outside begin_stream() / end_stream()");
+    }
+    RuntimeDims dims;
+    dims.point_features_ = voxel.num_point_features;
+    dims.channels_ = packed_.channels;
+    dispatch_dims(dims, [&](const auto& d) {
+        accumulate_dynamic(d, points, num_points, 0, 0, stream_roi_.get(), stream_);
+    });
+}
+
+void PFN_CPU::end_stream(SparsePillars& out) {
+    if (!stream_active_) {
+        throw std::logic_error("PFN_CPU::end_stream called without begin_stream()");
+    }
+    stream_active_ = false;
+    stream_roi_.reset();
+    finish_dynamic(0, 0, stream_);
+    // 交换而不是拷贝：两边的缓冲区容量都留给下一帧
+    std::swap(out, stream_);
+}
+
+void PFN_CPU::run(const VoxelInfo& voxel_data, float* rpn_input_map) {
+    // 先算稀疏特征，再用稠密回退写入 [N, 64, 496, 432]
+    // Scatter: 直接赋值到 BEV grid (不是 max)
+    run_sparse(voxel_data, scratch_);
+    scatter_sparse_to_dense(scratch_, rpn_input_map);
+}
+
+void PFN_CPU::run_incremental(const VoxelInfo& voxel_data, float* rpn_input_map) {
+    if (!cache_enabled_) {
+        throw std::logic_error("PFN_CPU::run_incremental requires enable_cache()");
+    }
+
+    run_sparse(voxel_data, scratch_);
+    // map 中是当前 key 的上一帧时只写差异；换了缓冲区、第一次调用或中间处理过别的 key 时完整写一遍
+    if (rpn_input_map == incremental_map_ && scratch_.base_frame != 0 &&
+        scratch_.base_frame == incremental_frame_) {
+        scatter_pillar_delta(scratch_, rpn_input_map);
+    } else {
+        scatter_sparse_to_dense(scratch_, rpn_input_map);
+    }
+    incremental_map_ = rpn_input_map;
+    incremental_frame_ = scratch_.frame;
 }
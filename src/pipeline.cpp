@@ -0,0 +1,265 @@
+#include "pipeline.h"
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::high_resolution_clock;
+
+double elapsed_ms(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+PipelineConfig apply_verbosity(PipelineConfig config) {
+    config.voxel.verbose = config.verbose;
+    config.prefilter.verbose = config.verbose;
+    config.decode.verbose = config.verbose;
+    config.center.verbose = config.verbose;
+    config.prefilter.crop_range = config.voxel.point_cloud_range;
+    return config;
+}
+
+} // namespace
+
+Pipeline::Pipeline(const PipelineConfig& config, PFN_CPU pfn, std::unique_ptr<RPNBackend> backend)
+    : config_(apply_verbosity(config)),
+      voxelizer_(config_.voxel),
+      prefilter_(config_.prefilter),
+      pfn_(std::move(pfn)),
+      backend_(std::move(backend)),
+      decoder_(config_.decode),
+      center_decoder_(config_.center) {
+    
+    if (!backend_) {
+        throw std::invalid_argument("Pipeline: backend is null");
+    }
+    pfn_.grid_w = config_.decode.grid_x;
+    pfn_.grid_h = config_.decode.grid_y;
+    pfn_.voxel = config_.voxel;
+    if (config_.dynamic_voxelization) {
+        if (config_.pillar_cache) {
+            throw std::invalid_argument("Pipeline: 动态体素化不支持 pillar_cache");
+        }
+        if (config_.voxel.budget != VoxelBudget::FirstArrival) {
+            throw std::invalid_argument("Pipeline: 动态体素化只支持 VoxelBudget::FirstArrival");
+        }
+    }
+    if (!config_.roi_polygons.empty()) {
+        if (config_.head != HeadType::Anchor) {
+            throw std::invalid_argument("Pipeline: ROI 目前只支持 anchor head");
+        }
+        const auto& dc = config_.decode;
+        auto roi = std::make_shared<RoiMask>(dc.grid_x, dc.grid_y, dc.x_min, dc.y_min,
+                                             dc.voxel_size_x, dc.voxel_size_y);
+        for (const auto& polygon : config_.roi_polygons) {
+            roi->add_polygon(polygon);
+        }
+        roi_ = roi;
+    }
+    pfn_.roi = roi_;
+    if (config_.pillar_cache) {
+        pfn_.enable_cache(config_.pillar_cache_step);
+    }
+    if (config_.max_batch < 1 || config_.max_batch > backend_->max_batch()) {
+        throw std::invalid_argument("Pipeline: max_batch 必须在 [1, backend max_batch] 内");
+    }
+    
+    const auto& dc = config_.decode;
+    if (config_.head == HeadType::Center) {
+        const auto& cc = config_.center;
+        const size_t plane = static_cast<size_t>(cc.grid_x) * cc.grid_y;
+        box_frame_size_ = static_cast<size_t>(cc.code_size) * plane;
+        score_frame_size_ = static_cast<size_t>(cc.num_classes) * plane;
+        dir_frame_size_ = 0;
+    } else {
+        const size_t plane = static_cast<size_t>(dc.grid_x) * dc.grid_y;
+        const size_t num_anchors = dc.anchor_sizes.size() * dc.num_rot;
+        box_frame_size_ = num_anchors * dc.box_code_size * plane;
+        score_frame_size_ = num_anchors * dc.num_classes * plane;
+        dir_frame_size_ = num_anchors * dc.num_dir_bins * plane;
+    }
+    box_map_.resize(box_frame_size_ * config_.max_batch);
+    score_map_.resize(score_frame_size_ * config_.max_batch);
+}
+
+std::vector<Box3D> Pipeline::process(const std::vector<float>& points, StageTimings* timings,
+                                     FrameQuality quality, int sensor_id) {
+    auto frames = process_batch({points}, timings, quality, sensor_id);
+    return std::move(frames[0]);
+}
+
+std::vector<std::vector<Box3D>> Pipeline::process_batch(
+    const std::vector<std::vector<float>>& frames,
+    StageTimings* timings,
+    FrameQuality quality,
+    int sensor_id) {
+    
+    const int batch_size = static_cast<int>(frames.size());
+    if (batch_size < 1 || batch_size > config_.max_batch) {
+        throw std::invalid_argument("Pipeline: 帧数超出范围 [1, max_batch]");
+    }
+    
+    const bool degraded = quality == FrameQuality::Degraded;
+    const float score_thr = degraded ? config_.degraded_score_thr : config_.score_thr;
+    voxelizer_.set_max_voxels(degraded ? config_.degraded_max_voxels : config_.voxel.max_voxels);
+    
+    StageTimings t;
+    const auto total_start = Clock::now();
+    
+    // 1. 预过滤（只对 4 通道的原始点云）
+    auto t0 = Clock::now();
+    std::vector<std::vector<float>> filtered;
+    const bool prefilter = config_.use_prefilter && config_.voxel.num_point_features == 4;
+    if (prefilter) {
+        filtered.reserve(frames.size());
+        for (const auto& f : frames) {
+            filtered.push_back(prefilter_.apply(f));
+        }
+    }
+    const auto& inputs = prefilter ? filtered : frames;
+    t.prefilter_ms = elapsed_ms(t0);
+    
+    if (config_.dynamic_voxelization) {
+        // 2+3. 动态体素化：点直接进 PFN，体素化耗时计入 pfn_ms
+        t0 = Clock::now();
+        std::vector<std::vector<PointSpan>> spans(batch_size);
+        for (int b = 0; b < batch_size; ++b) {
+            spans[b].push_back({inputs[b].data(), inputs[b].size() / config_.voxel.num_point_features});
+        }
+        pfn_.voxel.max_voxels = voxelizer_.max_voxels();
+        pfn_.run_dynamic(spans, pillars_);
+        t.pfn_ms = elapsed_ms(t0);
+    } else {
+        // 2. 体素化：所有帧进同一个张量，batch id = 帧序号
+        t0 = Clock::now();
+        VoxelData voxel_data = voxelizer_.generate_batch(inputs);
+        t.voxel_ms = elapsed_ms(t0);
+        
+        // 3. PFN -> 稀疏特征（cell 索引带 batch 偏移）
+        t0 = Clock::now();
+        pfn_.set_cache_key(sensor_id);
+        pfn_.run_sparse(make_voxel_info(voxel_data, config_.voxel, batch_size), pillars_);
+        t.pfn_ms = elapsed_ms(t0);
+    }
+    
+    auto results = run_heads(batch_size, score_thr, t);
+    
+    t.total_ms = elapsed_ms(total_start);
+    if (timings) {
+        *timings = t;
+    }
+    return results;
+}
+
+void Pipeline::begin_frame(FrameQuality quality, int sensor_id) {
+    stream_quality_ = quality;
+    stream_sensor_ = sensor_id;
+    stream_timings_ = StageTimings();
+    const int max_voxels = quality == FrameQuality::Degraded ? config_.degraded_max_voxels : config_.voxel.max_voxels;
+    voxelizer_.set_max_voxels(max_voxels);
+    if (config_.dynamic_voxelization) {
+        pfn_.voxel.max_voxels = max_voxels;
+        pfn_.begin_stream();
+    } else {
+        voxelizer_.begin_frame();
+    }
+    streaming_ = true;
+}
+
+void Pipeline::add_points(const float* points, size_t num_points) {
+    if (!streaming_) {
+        throw std::logic_error("Pipeline: add_points 需要先调用 begin_frame");
+    }
+    auto t0 = Clock::now();
+    const bool prefilter = config_.use_prefilter && config_.voxel.num_point_features == 4;
+    if (prefilter) {
+        stream_chunk_.resize(num_points * 4);
+        num_points = prefilter_.apply(points, num_points, stream_chunk_.data());
+        points = stream_chunk_.data();
+    }
+    stream_timings_.prefilter_ms += elapsed_ms(t0);
+    
+    t0 = Clock::now();
+    if (config_.dynamic_voxelization) {
+        pfn_.add_points(points, num_points);
+        stream_timings_.pfn_ms += elapsed_ms(t0);
+    } else {
+        voxelizer_.add_points(points, num_points);
+        stream_timings_.voxel_ms += elapsed_ms(t0);
+    }
+}
+
+std::vector<Box3D> Pipeline::end_frame(StageTimings* timings) {
+    if (!streaming_) {
+        throw std::logic_error("Pipeline: end_frame 需要先调用 begin_frame");
+    }
+    streaming_ = false;
+    
+    StageTimings t = stream_timings_;
+    const auto total_start = Clock::now();
+    
+    // 2+3. 收尾：动态体素化只剩 pillar 常数项；填充路径做预算 / 排序 / 收集后跑 PFN
+    auto t0 = Clock::now();
+    if (config_.dynamic_voxelization) {
+        pfn_.end_stream(pillars_);
+        t.pfn_ms += elapsed_ms(t0);
+    } else {
+        VoxelData voxel_data = voxelizer_.end_frame();
+        t.voxel_ms += elapsed_ms(t0);
+        
+        t0 = Clock::now();
+        pfn_.set_cache_key(stream_sensor_);
+        pfn_.run_sparse(make_voxel_info(voxel_data, config_.voxel), pillars_);
+        t.pfn_ms += elapsed_ms(t0);
+    }
+    
+    const bool degraded = stream_quality_ == FrameQuality::Degraded;
+    auto results = run_heads(1, degraded ? config_.degraded_score_thr : config_.score_thr, t);
+    
+    t.total_ms = elapsed_ms(total_start);
+    if (timings) {
+        *timings = t;
+    }
+    return std::move(results[0]);
+}
+
+std::vector<std::vector<Box3D>> Pipeline::run_heads(int batch_size, float score_thr, StageTimings& t) {
+    // 4. 一次后端调用处理所有帧
+    auto t0 = Clock::now();
+    backend_->run_sparse(pillars_, box_map_.data(), score_map_.data());
+    t.rpn_ms = elapsed_ms(t0);
+    
+    // 5. Decode + NMS 按帧拆开；center head 的 top-K 即最终结果，不做 NMS
+    std::vector<std::vector<Box3D>> results(batch_size);
+    const float* dir_map = backend_->dir_map();
+    for (int b = 0; b < batch_size; ++b) {
+        t0 = Clock::now();
+        if (config_.head == HeadType::Center) {
+            results[b] = center_decoder_.decode(score_map_.data() + b * score_frame_size_,
+                                                box_map_.data() + b * box_frame_size_,
+                                                score_thr, config_.max_num);
+            t.decode_ms += elapsed_ms(t0);
+            continue;
+        }
+
+        auto decoded = decoder_.decode(box_map_.data() + b * box_frame_size_,
+                                       score_map_.data() + b * score_frame_size_,
+                                       score_thr,
+                                       dir_map ? dir_map + b * dir_frame_size_ : nullptr,
+                                       roi_.get());
+        // decode 输出已按 score 降序
+        if (config_.nms_pre > 0 && decoded.size() > static_cast<size_t>(config_.nms_pre)) {
+            decoded.resize(config_.nms_pre);
+        }
+        t.decode_ms += elapsed_ms(t0);
+        
+        t0 = Clock::now();
+        results[b] = config_.nms_threads == 1
+            ? nms_bev_rotated(decoded, config_.nms_thr, config_.max_num, config_.verbose)
+            : nms_bev_rotated_parallel(decoded, config_.nms_thr, config_.max_num,
+                                       config_.nms_threads, config_.verbose);
+        t.nms_ms += elapsed_ms(t0);
+    }
+    
+    return results;
+}
@@ -1,23 +1,24 @@
 #include "postprocess.h"
+#include "pillar_config.h"
+#include "vec_math.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <numeric>
 #include <stdexcept>
+#include <thread>
 
 namespace {
 
-inline float sigmoid(float x) {
-    return 1.0f / (1.0f + std::exp(-x));
-}
+constexpr float kPi = 3.14159265358979323846f;
 
-inline float normalize_angle(float a) {
-    // normalize to [-pi, pi]
-    static constexpr float kPi = 3.14159265358979323846f;
-    while (a > kPi) a -= 2 * kPi;
-    while (a < -kPi) a += 2 * kPi;
-    return a;
+// 无分支角度回绕到 [-offset * period, (1 - offset) * period)，同 mmdet3d 的 limit_period
+inline float limit_period(float val, float offset, float period) {
+    return val - std::floor(val / period + offset) * period;
 }
 
 struct Vec2 { float x, y; };
@@ -26,20 +27,21 @@ inline Vec2 rotate(const Vec2& p, float c, float s) {
     return {p.x * c - p.y * s, p.x * s + p.y * c};
 }
 
-inline std::array<Vec2, 4> box_corners_bev(const Box3D& b) {
-    // center (x,y), size (l along x', w along y') in box local frame
+using Corners = std::array<Vec2, 4>;
+
+inline Corners box_corners_bev(const Box3D& b, float c, float s) {
+    // center (x,y), size (l along x', w along y') in box local frame; c/s = cos/sin(rot)
     float hl = b.l * 0.5f;
     float hw = b.w * 0.5f;
-    float c = std::cos(b.rot);
-    float s = std::sin(b.rot);
 
+    // 逆时针顺序：clip_polygon 以边的左侧为内侧
     std::array<Vec2, 4> local = {{
         {+hl, +hw},
-        {+hl, -hw},
-        {-hl, -hw},
         {-hl, +hw},
+        {-hl, -hw},
+        {+hl, -hw},
     }};
-    std::array<Vec2, 4> world;
+    Corners world;
     for (int i = 0; i < 4; ++i) {
         Vec2 r = rotate(local[i], c, s);
         world[i] = {r.x + b.x, r.y + b.y};
@@ -97,11 +99,8 @@ std::vector<Vec2> clip_polygon(const std::vector<Vec2>& subject, const Vec2& a,
     return out;
 }
 
-float iou_bev_rotated(const Box3D& a, const Box3D& b) {
+float iou_bev_rotated(const Box3D& a, const Corners& ca, const Box3D& b, const Corners& cb) {
     // rotated rectangle IoU in BEV using polygon clipping
-    auto ca = box_corners_bev(a);
-    auto cb = box_corners_bev(b);
-
     std::vector<Vec2> poly;
     poly.reserve(4);
     for (int i = 0; i < 4; ++i) poly.push_back(ca[i]);
@@ -141,130 +140,203 @@ AnchorDecoder::AnchorDecoder(DecodeConfig cfg) : cfg_(std::move(cfg)) {
     if (cfg_.num_classes <= 0) {
         throw std::invalid_argument("DecodeConfig: num_classes must be > 0");
     }
-}
+    if (cfg_.box_code_size < 7) {
+        throw std::invalid_argument("DecodeConfig: box_code_size must be >= 7");
+    }
+    if (cfg_.num_dir_bins < 1) {
+        throw std::invalid_argument("DecodeConfig: num_dir_bins must be >= 1");
+    }
+    if (!cfg_.rotations.empty() && static_cast<int>(cfg_.rotations.size()) != cfg_.num_rot) {
+        throw std::invalid_argument("DecodeConfig: rotations.size() must equal num_rot");
+    }
 
-std::vector<Box3D> AnchorDecoder::decode(
-    const float* box_map,
-    const float* score_map,
-    float score_thresh) const {
-    if (!box_map || !score_map) return {};
+    // anchor 中心：网格 cell 中心
+    anchors_.center_x.resize(cfg_.grid_x);
+    anchors_.center_y.resize(cfg_.grid_y);
+    for (int x = 0; x < cfg_.grid_x; ++x) {
+        anchors_.center_x[x] = x * cfg_.voxel_size_x + cfg_.x_min + cfg_.voxel_size_x * 0.5f;
+    }
+    for (int y = 0; y < cfg_.grid_y; ++y) {
+        anchors_.center_y[y] = y * cfg_.voxel_size_y + cfg_.y_min + cfg_.voxel_size_y * 0.5f;
+    }
 
-    const int H = cfg_.grid_y;
-    const int W = cfg_.grid_x;
-    const int stride = H * W;
+    // anchor 顺序：a = type * num_rot + rot
+    for (size_t t = 0; t < cfg_.anchor_sizes.size(); ++t) {
+        const auto& as = cfg_.anchor_sizes[t];
+        for (int r = 0; r < cfg_.num_rot; ++r) {
+            const float rot = cfg_.rotations.empty() ? r * kPi / cfg_.num_rot : cfg_.rotations[r];
+            anchors_.w.push_back(as.w);
+            anchors_.l.push_back(as.l);
+            anchors_.h.push_back(as.h);
+            anchors_.z.push_back(as.z_center);
+            anchors_.rot.push_back(rot);
+            anchors_.diagonal.push_back(std::sqrt(as.l * as.l + as.w * as.w));
+            anchors_.label.push_back(static_cast<int>(t));
+        }
+    }
+}
 
-    const int num_types = static_cast<int>(cfg_.anchor_sizes.size());
-    const int num_anchors = num_types * cfg_.num_rot;
+namespace {
 
-    // rotations: [0, 1.57] by default
-    std::vector<float> rots(cfg_.num_rot, 0.0f);
-    if (cfg_.num_rot >= 2) rots[1] = 1.57079632679f;
-    for (int i = 2; i < cfg_.num_rot; ++i) rots[i] = rots[i - 1]; // fallback
+// decode 主循环：按 anchor 通道遍历，score / box 每个通道都是连续的 [H, W] 平面。
+// 先用 logit 阈值（sigmoid 单调）筛掉绝大多数位置，候选按批走 vecmath 的 sigmoid / exp，
+// 再精确比较阈值。方向分类在 gather 候选时顺带完成，不额外扫描 map。
+// Dims 为 StaticDims<预设> 时 anchor / 类别 / 回归通道数是编译期常量
+template <class Dims>
+std::vector<Box3D> decode_impl(
+    const Dims& dims,
+    const DecodeConfig& cfg,
+    const AnchorTable& anchors,
+    const float* box_map,
+    const float* score_map,
+    const float* dir_map,
+    float score_thresh,
+    const RoiMask* roi,
+    AnchorDecodeScratch& scratch) {
+    const int H = cfg.grid_y;
+    const int W = cfg.grid_x;
+    const size_t stride = static_cast<size_t>(H) * W;
+
+    // 要扫描的像素区间：有 ROI 时只扫 ROI 内的行区间，否则整个平面
+    const std::pair<int32_t, int32_t> full_plane(0, static_cast<int32_t>(stride));
+    const std::pair<int32_t, int32_t>* spans = roi ? roi->spans().data() : &full_plane;
+    const size_t num_spans = roi ? roi->spans().size() : 1;
+
+    const int num_anchors = dims.num_anchors();
+    const int num_classes = dims.num_classes();
+    const int code_size = dims.box_code_size();
+    const int num_dir_bins = cfg.num_dir_bins;
+    const float dir_period = 2.0f * kPi / num_dir_bins;
+
+    // sigmoid(logit) >= t  <=>  logit >= log(t / (1 - t))；留一点余量，边界上由精确比较决定
+    float logit_thresh = -std::numeric_limits<float>::infinity();
+    if (score_thresh >= 1.0f) {
+        return {};
+    } else if (score_thresh > 0.0f) {
+        logit_thresh = std::log(score_thresh / (1.0f - score_thresh)) - 1e-4f;
+    }
 
     std::vector<Box3D> out;
     out.reserve(4096);
+    std::vector<int> order;  // 每个候选的 (pixel * num_anchors + a)，排序时打破同分
+    order.reserve(4096);
+    // 每个 anchor 平面的候选缓冲，跨帧复用，只在网格变大时增长（不清零，只读已写入的部分）；
+    // reg 为 7 段 SoA（段长 = 候选数）
+    if (scratch.cand_pixel.size() < stride) {
+        scratch.cand_pixel.resize(stride);
+        scratch.cand_logit.resize(stride);
+    }
+    int* cand_pixel = scratch.cand_pixel.data();
+    float* cand_logit = scratch.cand_logit.data();
+    std::vector<float>& cand_score = scratch.cand_score;
+    std::vector<float>& reg = scratch.reg;
+
+    if (cfg.verbose) {
+        std::cout << "  开始遍历 " << num_anchors << " 个 anchor × " << stride << " 个像素位置..." << std::endl;
+        std::cout.flush();  // 强制刷新输出缓冲区
+    }
 
-    int processed_pixels = 0;
-    int total_pixels = H * W;
-    const int progress_interval = std::max(1, total_pixels / 20);  // 每5%输出一次
-    std::cout << "  开始遍历 " << total_pixels << " 个像素位置..." << std::endl;
-    std::cout.flush();  // 强制刷新输出缓冲区
-
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            processed_pixels++;
-            if (processed_pixels % progress_interval == 0 || processed_pixels == total_pixels) {
-                std::cout << "  Decode进度: " << (processed_pixels * 100 / total_pixels) 
-                          << "%, 当前候选框数: " << out.size() << std::endl;
-                std::cout.flush();  // 强制刷新
+    for (int a = 0; a < num_anchors; ++a) {
+        // 只取该类别对应的通道分数：通道索引 = Anchor总索引 * 类别数 + 目标类别
+        const int target_cls = anchors.label[a];
+        const float* score_plane = score_map + (static_cast<size_t>(a) * num_classes + target_cls) * stride;
+        // box reg channels: [a*code_size + k, y, x]
+        const float* box_plane = box_map + static_cast<size_t>(a) * code_size * stride;
+        // dir channels: [a*num_dir_bins + k, y, x]
+        const float* dir_plane = dir_map ? dir_map + static_cast<size_t>(a) * num_dir_bins * stride : nullptr;
+
+        const float aw = anchors.w[a];
+        const float al = anchors.l[a];
+        const float ah = anchors.h[a];
+        const float az = anchors.z[a];
+        const float diagonal = anchors.diagonal[a];
+
+        // 1) logit 预筛选，无分支地压缩出候选像素
+        size_t num_cand = 0;
+        for (size_t k = 0; k < num_spans; ++k) {
+            for (int32_t pixel = spans[k].first; pixel < spans[k].second; ++pixel) {
+                const float v = score_plane[pixel];
+                cand_pixel[num_cand] = pixel;
+                cand_logit[num_cand] = v;
+                num_cand += (v >= logit_thresh);
             }
-            const int pixel = y * W + x;
-
-            // anchor center based on grid cell center
-            const float xa = x * cfg_.voxel_size_x + cfg_.x_min + cfg_.voxel_size_x * 0.5f;
-            const float ya = y * cfg_.voxel_size_y + cfg_.y_min + cfg_.voxel_size_y * 0.5f;
-
-            for (int a = 0; a < num_anchors; ++a) {
-                const int type_idx = a / cfg_.num_rot;
-                const int rot_idx = a % cfg_.num_rot;
-                const auto& as = cfg_.anchor_sizes[type_idx];
-
-                // score: per-class or single-class
-                // float best_score = -1e9f;
-                // int best_cls = 0;
-                // for (int c = 0; c < cfg_.num_classes; ++c) {
-                //     const int ch = a * cfg_.num_classes + c;
-                //     const float logit = score_map[ch * stride + pixel];
-                //     const float sc = sigmoid(logit);
-                //     if (sc > best_score) {
-                //         best_score = sc;
-                //         best_cls = c;
-                //     }
-                // }
-                // if (best_score < score_thresh) continue;
-                const int target_cls = type_idx; 
-
-                // 2. 只取该类别对应的通道分数
-                // 通道索引 = Anchor总索引 * 类别数 + 目标类别
-                const int ch = a * cfg_.num_classes + target_cls; 
-                const int score_idx = ch * stride + pixel;
-                if (score_idx < 0 || score_idx >= (H * W * num_anchors * cfg_.num_classes)) {
-                    continue;  // 边界检查
-                }
-                const float logit = score_map[score_idx];
-                const float score = sigmoid(logit);
-
-                if (score < score_thresh) continue;
+        }
 
-                // box reg channels: [a*7 + k, y, x]
-                const int base_ch = a * 7;
-                const int box_base_idx = base_ch * stride + pixel;
-                if (box_base_idx < 0 || box_base_idx >= static_cast<int>(H * W * num_anchors * 7)) {
-                    continue;  // 边界检查
-                }
-                
-                // 读取box回归值，并检查是否异常
-                float dx = box_map[(base_ch + 0) * stride + pixel];
-                float dy = box_map[(base_ch + 1) * stride + pixel];
-                float dz = box_map[(base_ch + 2) * stride + pixel];
-                float dw = box_map[(base_ch + 3) * stride + pixel];
-                float dl = box_map[(base_ch + 4) * stride + pixel];
-                float dh = box_map[(base_ch + 5) * stride + pixel];
-                float dr = box_map[(base_ch + 6) * stride + pixel];
-                
-                // 检查值是否异常（回归值通常不会太大）
-                if (!std::isfinite(dx) || !std::isfinite(dy) || !std::isfinite(dz) ||
-                    !std::isfinite(dw) || !std::isfinite(dl) || !std::isfinite(dh) || !std::isfinite(dr)) {
-                    continue;  // 跳过NaN/Inf
-                }
-                if (std::abs(dx) > 100.0f || std::abs(dy) > 100.0f || std::abs(dz) > 100.0f ||
-                    std::abs(dw) > 10.0f || std::abs(dl) > 10.0f || std::abs(dh) > 10.0f || std::abs(dr) > 3.14f) {
-                    continue;  // 跳过异常大的值
+        // 2) 批量 sigmoid，精确阈值比较，同时 gather 回归值并剔除异常
+        //    !(|v| <= lim) 同时拦下 NaN / Inf 和异常大的值（回归值通常不会太大）
+        //    角度在这里就解码好：有方向 head 时先把 rot 折到一个 bin 的周期内，再按 argmax 加回 bin 偏移
+        cand_score.resize(num_cand);
+        reg.resize(7 * num_cand);
+        vecmath::sigmoid(cand_logit, cand_score.data(), num_cand);
+
+        size_t n = 0;
+        for (size_t i = 0; i < num_cand; ++i) {
+            if (cand_score[i] < score_thresh) continue;
+            const size_t pixel = static_cast<size_t>(cand_pixel[i]);
+            float d[7];
+            for (int k = 0; k < 7; ++k) d[k] = box_plane[k * stride + pixel];
+            if (!(std::abs(d[0]) <= 100.0f) || !(std::abs(d[1]) <= 100.0f) || !(std::abs(d[2]) <= 100.0f) ||
+                !(std::abs(d[3]) <= 10.0f) || !(std::abs(d[4]) <= 10.0f) || !(std::abs(d[5]) <= 10.0f) ||
+                !(std::abs(d[6]) <= 3.14f)) {
+                continue;
+            }
+            float rot = anchors.rot[a] + d[6];
+            if (dir_plane) {
+                int bin = 0;
+                float best = dir_plane[pixel];
+                for (int k = 1; k < num_dir_bins; ++k) {
+                    const float v = dir_plane[k * stride + pixel];
+                    bin = v > best ? k : bin;
+                    best = v > best ? v : best;
                 }
-
-                const float diagonal = std::sqrt(as.l * as.l + as.w * as.w);
-
-                Box3D b;
-                b.x = xa + dx * diagonal;
-                b.y = ya + dy * diagonal;
-                b.z = as.z_center + dz * as.h;
-                b.w = as.w * std::exp(dw);
-                b.l = as.l * std::exp(dl);
-                b.h = as.h * std::exp(dh);
-                b.rot = normalize_angle(rots[rot_idx] + dr);
-                b.score = score;
-                // label：默认用 anchor type（类别）作为 label；如果你的 score 是 per-class，这里更合理用 best_cls
-                // b.label = (cfg_.num_classes > 1) ? best_cls : type_idx;
-                b.label = target_cls; // 强制与 Anchor 类型一致
-
-                out.push_back(b);
+                rot = limit_period(rot - cfg.dir_offset, cfg.dir_limit_offset, dir_period) +
+                      cfg.dir_offset + dir_period * bin;
             }
+            d[6] = limit_period(rot, 0.5f, 2.0f * kPi);  // 输出统一在 [-pi, pi)
+
+            cand_pixel[n] = cand_pixel[i];
+            cand_score[n] = cand_score[i];
+            for (int k = 0; k < 7; ++k) reg[k * num_cand + n] = d[k];
+            ++n;
+        }
+
+        // 3) dw / dl / dh 三段各 n 个，批量 exp
+        float* dwlh = reg.data() + 3 * num_cand;
+        if (n != num_cand) {
+            std::copy_n(reg.data() + 4 * num_cand, n, dwlh + n);
+            std::copy_n(reg.data() + 5 * num_cand, n, dwlh + 2 * n);
+        }
+        vecmath::exp(dwlh, dwlh, 3 * n);
+
+        for (size_t i = 0; i < n; ++i) {
+            const int pixel = cand_pixel[i];
+            const int y = pixel / W;
+            const int x = pixel - y * W;
+            Box3D b;
+            b.x = anchors.center_x[x] + reg[0 * num_cand + i] * diagonal;
+            b.y = anchors.center_y[y] + reg[1 * num_cand + i] * diagonal;
+            b.z = az + reg[2 * num_cand + i] * ah;
+            b.w = aw * dwlh[i];
+            b.l = al * dwlh[n + i];
+            b.h = ah * dwlh[2 * n + i];
+            b.rot = reg[6 * num_cand + i];
+            b.score = cand_score[i];
+            b.label = target_cls; // 强制与 Anchor 类型一致
+
+            out.push_back(b);
+            order.push_back(pixel * num_anchors + a);
+        }
+        if (cfg.verbose) {
+            std::cout << "  Decode进度: anchor " << (a + 1) << "/" << num_anchors
+                      << ", 当前候选框数: " << out.size() << std::endl;
         }
     }
 
     // 先按 score 排序，减少 NMS 负担
-    std::cout << "  Decode完成: 共 " << out.size() << " 个候选框" << std::endl;
-    std::cout.flush();
+    if (cfg.verbose) {
+        std::cout << "  Decode完成: 共 " << out.size() << " 个候选框" << std::endl;
+        std::cout.flush();
+    }
     
     if (out.size() > 100000) {
         std::cerr << "  警告: 候选框数量过多(" << out.size() 
@@ -272,11 +344,174 @@ std::vector<Box3D> AnchorDecoder::decode(
         std::cerr.flush();
     }
     
-    std::cout << "  开始排序候选框..." << std::endl;
-    std::cout.flush();
-    std::sort(out.begin(), out.end(), [](const Box3D& a, const Box3D& b) { return a.score > b.score; });
-    std::cout << "  排序完成" << std::endl;
-    std::cout.flush();
+    if (cfg.verbose) {
+        std::cout << "  开始排序候选框..." << std::endl;
+        std::cout.flush();
+    }
+    // 同分时按 (像素, anchor) 排序，结果与遍历顺序无关
+    std::vector<int> idx(out.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    std::sort(idx.begin(), idx.end(), [&](int i, int j) {
+        if (out[i].score != out[j].score) return out[i].score > out[j].score;
+        return order[i] < order[j];
+    });
+    std::vector<Box3D> sorted(out.size());
+    for (size_t i = 0; i < idx.size(); ++i) sorted[i] = out[idx[i]];
+    if (cfg.verbose) {
+        std::cout << "  排序完成" << std::endl;
+        std::cout.flush();
+    }
+    return sorted;
+}
+
+} // namespace
+
+std::vector<Box3D> AnchorDecoder::decode(
+    const float* box_map,
+    const float* score_map,
+    float score_thresh,
+    const float* dir_map,
+    const RoiMask* roi) {
+    if (!box_map || !score_map) return {};
+    if (roi && (roi->grid_x() != cfg_.grid_x || roi->grid_y() != cfg_.grid_y)) {
+        throw std::invalid_argument("AnchorDecoder: ROI grid does not match the decode grid");
+    }
+
+    RuntimeDims dims;
+    dims.num_anchors_ = static_cast<int>(cfg_.anchor_sizes.size()) * cfg_.num_rot;
+    dims.num_rot_ = cfg_.num_rot;
+    dims.num_classes_ = cfg_.num_classes;
+    dims.box_code_size_ = cfg_.box_code_size;
+    return dispatch_dims(dims, [&](const auto& d) {
+        return decode_impl(d, cfg_, anchors_, box_map, score_map, dir_map, score_thresh, roi, scratch_);
+    });
+}
+
+// -------------------------
+// Center head decode（CenterPoint 风格）
+// -------------------------
+
+CenterDecoder::CenterDecoder(CenterHeadConfig cfg) : cfg_(std::move(cfg)) {
+    if (cfg_.grid_x <= 0 || cfg_.grid_y <= 0) {
+        throw std::invalid_argument("CenterHeadConfig: invalid grid size");
+    }
+    if (cfg_.out_size_factor < 1) {
+        throw std::invalid_argument("CenterHeadConfig: out_size_factor must be >= 1");
+    }
+    if (cfg_.num_classes <= 0) {
+        throw std::invalid_argument("CenterHeadConfig: num_classes must be > 0");
+    }
+    if (cfg_.code_size < 8) {
+        throw std::invalid_argument("CenterHeadConfig: code_size must be >= 8");
+    }
+    if (static_cast<size_t>(cfg_.grid_x) * cfg_.grid_y * cfg_.num_classes >
+        static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw std::invalid_argument("CenterHeadConfig: heatmap too large");
+    }
+}
+
+std::vector<Box3D> CenterDecoder::decode(
+    const float* heatmap,
+    const float* reg_map,
+    float score_thresh,
+    int max_num) const {
+    if (!heatmap || !reg_map || max_num <= 0 || score_thresh >= 1.0f) return {};
+
+    const int W = cfg_.grid_x;
+    const int H = cfg_.grid_y;
+    const size_t stride = static_cast<size_t>(W) * H;
+
+    // 同 AnchorDecoder：先在 logit 上粗筛，sigmoid 之后再精确比较
+    float logit_thresh = -std::numeric_limits<float>::infinity();
+    if (score_thresh > 0.0f) {
+        logit_thresh = std::log(score_thresh / (1.0f - score_thresh)) - 1e-4f;
+    }
+
+    // 1) 3x3 max-pool 峰值：逐行先纵向取三行的 max，再横向取相邻三列的 max；
+    //    边界复制本行 / 本列（max 不变，等价于 -inf 填充）。sigmoid 单调，直接在 logit 上比较。
+    //    候选无分支压缩，每行前保证还有 W 个空位
+    struct Peak {
+        float logit;
+        int index;  // cls * stride + pixel
+    };
+    std::vector<Peak> peaks(static_cast<size_t>(W) * 64);
+    std::vector<float> col_max(static_cast<size_t>(W) + 2);
+    std::vector<float> pooled(W);
+    size_t num_peaks = 0;
+
+    for (int cls = 0; cls < cfg_.num_classes; ++cls) {
+        const float* plane = heatmap + static_cast<size_t>(cls) * stride;
+        for (int y = 0; y < H; ++y) {
+            const float* row = plane + static_cast<size_t>(y) * W;
+            const float* up = y > 0 ? row - W : row;
+            const float* down = y + 1 < H ? row + W : row;
+            vecmath::max3(up, row, down, col_max.data() + 1, W);
+            col_max[0] = col_max[1];
+            col_max[W + 1] = col_max[W];
+            vecmath::max3(col_max.data(), col_max.data() + 1, col_max.data() + 2, pooled.data(), W);
+
+            if (peaks.size() < num_peaks + W) peaks.resize(std::max(peaks.size() * 2, num_peaks + W));
+            const int base = static_cast<int>(cls * stride + static_cast<size_t>(y) * W);
+            for (int x = 0; x < W; ++x) {
+                const float v = row[x];
+                peaks[num_peaks] = {v, base + x};
+                num_peaks += static_cast<size_t>((v >= pooled[x]) & (v >= logit_thresh));
+            }
+        }
+    }
+
+    // 2) top-K：nth_element 选出前 max_num 个，再只对这 K 个排序
+    const auto higher = [](const Peak& a, const Peak& b) {
+        if (a.logit != b.logit) return a.logit > b.logit;
+        return a.index < b.index;
+    };
+    const size_t k = std::min(num_peaks, static_cast<size_t>(max_num));
+    if (k < num_peaks) {
+        std::nth_element(peaks.begin(), peaks.begin() + k, peaks.begin() + num_peaks, higher);
+    }
+    std::sort(peaks.begin(), peaks.begin() + k, higher);
+
+    // 3) 批量 sigmoid / exp，逐框解码；回归值非有限的框丢弃
+    std::vector<float> logits(k), scores(k), dims(3 * k);
+    for (size_t i = 0; i < k; ++i) logits[i] = peaks[i].logit;
+    vecmath::sigmoid(logits.data(), scores.data(), k);
+    for (size_t i = 0; i < k; ++i) {
+        const size_t pixel = static_cast<size_t>(peaks[i].index) % stride;
+        for (int d = 0; d < 3; ++d) dims[3 * i + d] = reg_map[(3 + d) * stride + pixel];
+    }
+    vecmath::exp(dims.data(), dims.data(), 3 * k);
+
+    const float step_x = cfg_.out_size_factor * cfg_.voxel_size_x;
+    const float step_y = cfg_.out_size_factor * cfg_.voxel_size_y;
+    std::vector<Box3D> out;
+    out.reserve(k);
+    for (size_t i = 0; i < k; ++i) {
+        if (scores[i] < score_thresh) break;  // 已按 score 降序
+        const size_t pixel = static_cast<size_t>(peaks[i].index) % stride;
+        const int y = static_cast<int>(pixel / W);
+        const int x = static_cast<int>(pixel - static_cast<size_t>(y) * W);
+        float r[8];
+        for (int c = 0; c < 8; ++c) r[c] = reg_map[c * stride + pixel];
+        bool finite = true;
+        for (int c = 0; c < 8; ++c) finite = finite && std::isfinite(r[c]);
+        if (!finite) continue;
+
+        Box3D b;
+        b.x = (x + r[0]) * step_x + cfg_.x_min;
+        b.y = (y + r[1]) * step_y + cfg_.y_min;
+        b.z = r[2];
+        b.w = dims[3 * i];
+        b.l = dims[3 * i + 1];
+        b.h = dims[3 * i + 2];
+        b.rot = limit_period(std::atan2(r[6], r[7]), 0.5f, 2.0f * kPi);
+        b.score = scores[i];
+        b.label = static_cast<int>(static_cast<size_t>(peaks[i].index) / stride);
+        out.push_back(b);
+    }
+
+    if (cfg_.verbose) {
+        std::cout << "  Center decode: " << num_peaks << " 个峰值, 保留 " << out.size() << " 个框" << std::endl;
+    }
     return out;
 }
 
@@ -284,16 +519,154 @@ std::vector<Box3D> AnchorDecoder::decode(
 // NMS (rotated BEV IoU)
 // -------------------------
 
-std::vector<Box3D> nms_bev_rotated(const std::vector<Box3D>& boxes, float iou_thr, int max_num) {
-    if (boxes.empty()) return {};
-    
-    std::cout << "  NMS开始: 输入 " << boxes.size() << " 个候选框" << std::endl;
-    
+namespace {
+
+// 处理顺序：score 降序，同分按输入下标，串行 / 并行版本共用，保证结果一致
+std::vector<int> nms_order(const std::vector<Box3D>& boxes) {
     std::vector<int> idx(boxes.size());
     std::iota(idx.begin(), idx.end(), 0);
+    std::sort(idx.begin(), idx.end(), [&](int a, int b) {
+        if (boxes[a].score != boxes[b].score) return boxes[a].score > boxes[b].score;
+        return a < b;
+    });
+    return idx;
+}
+
+// 每个框的 BEV 角点只算一次，sin/cos 批量计算
+std::vector<Corners> nms_corners(const std::vector<Box3D>& boxes) {
+    const size_t n = boxes.size();
+    std::vector<float> rots(n), sins(n), coss(n);
+    for (size_t i = 0; i < n; ++i) rots[i] = boxes[i].rot;
+    vecmath::sincos(rots.data(), sins.data(), coss.data(), n);
+    std::vector<Corners> corners(n);
+    for (size_t i = 0; i < n; ++i) corners[i] = box_corners_bev(boxes[i], coss[i], sins[i]);
+    return corners;
+}
+
+// 同类框数超过该值才做空间拆分
+constexpr size_t kSpatialSplitMinBoxes = 256;
+// 空间拆分的栅格边长（米）；AABB 外扩一点，避免贴边的框因舍入误差被分开
+constexpr float kSplitCellSize = 2.0f;
+constexpr float kSplitAabbPad = 0.01f;
+constexpr size_t kSplitMaxCells = size_t(1) << 20;
+
+int find_root(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// 把一个类别的框（ranks 为排序名次，升序）拆成空间上互不相交的连通块：
+// AABB 不相交的两个框 IoU 为 0，不可能互相抑制，所以各连通块的贪心 NMS 相互独立。
+// 这里用栅格近似：落在同一格子里的框并到一起（只会多并，不会漏），每块内名次仍升序
+void split_spatial(
+    const std::vector<int>& ranks,
+    const std::vector<int>& order,
+    const std::vector<Corners>& corners,
+    std::vector<std::vector<int>>& partitions) {
+    const size_t m = ranks.size();
+    std::vector<std::array<float, 4>> aabb(m);  // min_x, min_y, max_x, max_y
+    float lo_x = std::numeric_limits<float>::max(), lo_y = lo_x;
+    float hi_x = std::numeric_limits<float>::lowest(), hi_y = hi_x;
+    for (size_t k = 0; k < m; ++k) {
+        const Corners& c = corners[order[ranks[k]]];
+        float x0 = c[0].x, x1 = c[0].x, y0 = c[0].y, y1 = c[0].y;
+        for (int i = 1; i < 4; ++i) {
+            x0 = std::min(x0, c[i].x);
+            x1 = std::max(x1, c[i].x);
+            y0 = std::min(y0, c[i].y);
+            y1 = std::max(y1, c[i].y);
+        }
+        if (!std::isfinite(x0) || !std::isfinite(x1) || !std::isfinite(y0) || !std::isfinite(y1)) {
+            partitions.push_back(ranks);  // 坐标异常，不拆
+            return;
+        }
+        aabb[k] = {x0 - kSplitAabbPad, y0 - kSplitAabbPad, x1 + kSplitAabbPad, y1 + kSplitAabbPad};
+        lo_x = std::min(lo_x, aabb[k][0]);
+        lo_y = std::min(lo_y, aabb[k][1]);
+        hi_x = std::max(hi_x, aabb[k][2]);
+        hi_y = std::max(hi_y, aabb[k][3]);
+    }
+
+    float cell = kSplitCellSize;
+    size_t nx = 0, ny = 0;
+    for (;;) {
+        nx = static_cast<size_t>((hi_x - lo_x) / cell) + 1;
+        ny = static_cast<size_t>((hi_y - lo_y) / cell) + 1;
+        if (nx * ny <= kSplitMaxCells) break;
+        cell *= 2.0f;
+    }
+
+    std::vector<int> parent(m);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<int> owner(nx * ny, -1);
+    for (size_t k = 0; k < m; ++k) {
+        const size_t cx0 = static_cast<size_t>((aabb[k][0] - lo_x) / cell);
+        const size_t cy0 = static_cast<size_t>((aabb[k][1] - lo_y) / cell);
+        const size_t cx1 = std::min(nx - 1, static_cast<size_t>((aabb[k][2] - lo_x) / cell));
+        const size_t cy1 = std::min(ny - 1, static_cast<size_t>((aabb[k][3] - lo_y) / cell));
+        for (size_t cy = cy0; cy <= cy1; ++cy) {
+            for (size_t cx = cx0; cx <= cx1; ++cx) {
+                int& o = owner[cy * nx + cx];
+                if (o < 0) {
+                    o = static_cast<int>(k);
+                } else {
+                    const int a = find_root(parent, o);
+                    const int b = find_root(parent, static_cast<int>(k));
+                    if (a != b) parent[std::max(a, b)] = std::min(a, b);
+                }
+            }
+        }
+    }
+
+    std::vector<int> slot(m, -1);
+    for (size_t k = 0; k < m; ++k) {
+        const int root = find_root(parent, static_cast<int>(k));
+        if (slot[root] < 0) {
+            slot[root] = static_cast<int>(partitions.size());
+            partitions.emplace_back();
+        }
+        partitions[slot[root]].push_back(ranks[k]);
+    }
+}
+
+// 单个分区（同一类别，名次升序）的贪心 NMS，返回保留框的名次
+std::vector<int> nms_partition(
+    const std::vector<Box3D>& boxes,
+    const std::vector<int>& order,
+    const std::vector<Corners>& corners,
+    const std::vector<int>& ranks,
+    float iou_thr,
+    int max_num) {
+    std::vector<int> kept;
+    std::vector<char> suppressed(ranks.size(), 0);
+    for (size_t p = 0; p < ranks.size(); ++p) {
+        if (suppressed[p]) continue;
+        const int i = order[ranks[p]];
+        kept.push_back(ranks[p]);
+        if (max_num > 0 && static_cast<int>(kept.size()) >= max_num) break;
+        for (size_t q = p + 1; q < ranks.size(); ++q) {
+            if (suppressed[q]) continue;
+            const int j = order[ranks[q]];
+            if (iou_bev_rotated(boxes[i], corners[i], boxes[j], corners[j]) > iou_thr) suppressed[q] = 1;
+        }
+    }
+    return kept;
+}
 
-    // 输入最好已按 score 降序；这里再保险排序一次
-    std::sort(idx.begin(), idx.end(), [&](int a, int b) { return boxes[a].score > boxes[b].score; });
+} // namespace
+
+std::vector<Box3D> nms_bev_rotated(const std::vector<Box3D>& boxes, float iou_thr, int max_num, bool verbose) {
+    if (boxes.empty()) return {};
+    
+    if (verbose) {
+        std::cout << "  NMS开始: 输入 " << boxes.size() << " 个候选框" << std::endl;
+    }
+    
+    const std::vector<int> idx = nms_order(boxes);
+    const std::vector<Corners> corners = nms_corners(boxes);
 
     std::vector<char> suppressed(boxes.size(), 0);
     std::vector<Box3D> keep;
@@ -303,7 +676,7 @@ std::vector<Box3D> nms_bev_rotated(const std::vector<Box3D>& boxes, float iou_th
     const size_t progress_step = std::max<size_t>(1, total / 20);  // 每5%输出一次
 
     for (size_t _i = 0; _i < idx.size(); ++_i) {
-        if (_i % progress_step == 0) {
+        if (verbose && _i % progress_step == 0) {
             std::cout << "  NMS进度: " << (_i * 100 / total) 
                       << "%, 已保留: " << keep.size() << std::endl;
         }
@@ -321,11 +694,83 @@ std::vector<Box3D> nms_bev_rotated(const std::vector<Box3D>& boxes, float iou_th
             // 常见做法：按类别分别 NMS；这里默认同类才抑制
             if (boxes[j].label != boxes[i].label) continue;
 
-            float iou = iou_bev_rotated(boxes[i], boxes[j]);
+            float iou = iou_bev_rotated(boxes[i], corners[i], boxes[j], corners[j]);
             if (iou > iou_thr) suppressed[j] = 1;
         }
     }
 
-    std::cout << "  NMS完成: 保留 " << keep.size() << " 个框" << std::endl;
+    if (verbose) {
+        std::cout << "  NMS完成: 保留 " << keep.size() << " 个框" << std::endl;
+    }
+    return keep;
+}
+
+std::vector<Box3D> nms_bev_rotated_parallel(
+    const std::vector<Box3D>& boxes,
+    float iou_thr,
+    int max_num,
+    int num_threads,
+    bool verbose) {
+    if (boxes.empty()) return {};
+
+    const std::vector<int> order = nms_order(boxes);
+    const std::vector<Corners> corners = nms_corners(boxes);
+
+    // 1) 按类别拆分（名次升序）
+    std::map<int, std::vector<int>> by_label;
+    for (size_t r = 0; r < order.size(); ++r) {
+        by_label[boxes[order[r]].label].push_back(static_cast<int>(r));
+    }
+
+    // 2) 框多的类别再按空间连通块拆分；iou_thr < 0 时不相交的框也会互相抑制，不能拆
+    std::vector<std::vector<int>> partitions;
+    for (auto& kv : by_label) {
+        if (kv.second.size() >= kSpatialSplitMinBoxes && iou_thr >= 0.0f) {
+            split_spatial(kv.second, order, corners, partitions);
+        } else {
+            partitions.push_back(std::move(kv.second));
+        }
+    }
+
+    // 3) 大分区先做，worker 从共享计数器领任务；调用线程也参与
+    std::vector<size_t> tasks(partitions.size());
+    std::iota(tasks.begin(), tasks.end(), 0);
+    std::sort(tasks.begin(), tasks.end(), [&](size_t a, size_t b) {
+        return partitions[a].size() > partitions[b].size();
+    });
+
+    std::vector<std::vector<int>> kept(partitions.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t t = next.fetch_add(1); t < tasks.size(); t = next.fetch_add(1)) {
+            const size_t p = tasks[t];
+            kept[p] = nms_partition(boxes, order, corners, partitions[p], iou_thr, max_num);
+        }
+    };
+
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    const size_t extra = std::min(tasks.size(), static_cast<size_t>(num_threads)) - 1;
+    std::vector<std::thread> threads;
+    threads.reserve(extra);
+    for (size_t i = 0; i < extra; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+
+    // 4) 按名次归并：串行版本保留的前 max_num 个框正是各分区保留框按名次排序后的前 max_num 个
+    std::vector<int> merged;
+    for (const auto& k : kept) merged.insert(merged.end(), k.begin(), k.end());
+    std::sort(merged.begin(), merged.end());
+    if (max_num > 0 && static_cast<int>(merged.size()) > max_num) merged.resize(max_num);
+
+    std::vector<Box3D> keep;
+    keep.reserve(merged.size());
+    for (int r : merged) keep.push_back(boxes[order[r]]);
+
+    if (verbose) {
+        std::cout << "  NMS完成: " << partitions.size() << " 个分区, " << (extra + 1)
+                  << " 个线程, 保留 " << keep.size() << " 个框" << std::endl;
+    }
     return keep;
 }
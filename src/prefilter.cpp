@@ -0,0 +1,113 @@
+#include "prefilter.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PREFILTER_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PREFILTER_NEON 1
+#endif
+
+PointPrefilter::PointPrefilter(const PrefilterConfig& config) : config_(config) {
+    if (config_.keep_every < 1) {
+        throw std::invalid_argument("PrefilterConfig: keep_every must be >= 1");
+    }
+    if (!config_.roi_polygon.empty() && config_.roi_polygon.size() < 3) {
+        throw std::invalid_argument("PrefilterConfig: roi_polygon needs at least 3 vertices");
+    }
+
+    const auto& r = config_.crop_range;
+    lo_ = {r[0], r[1], std::max(r[2], config_.z_band_min), config_.min_intensity};
+    hi_ = {r[3], r[4], std::min(r[5], config_.z_band_max), std::numeric_limits<float>::infinity()};
+
+    // Tighten the box to the polygon's bounding box so the vector compare
+    // rejects most outside points before the scalar polygon test runs
+    if (!config_.roi_polygon.empty()) {
+        float px_min = config_.roi_polygon[0][0], px_max = px_min;
+        float py_min = config_.roi_polygon[0][1], py_max = py_min;
+        for (const auto& v : config_.roi_polygon) {
+            px_min = std::min(px_min, v[0]);
+            px_max = std::max(px_max, v[0]);
+            py_min = std::min(py_min, v[1]);
+            py_max = std::max(py_max, v[1]);
+        }
+        lo_[0] = std::max(lo_[0], px_min);
+        lo_[1] = std::max(lo_[1], py_min);
+        hi_[0] = std::min(hi_[0], px_max);
+        hi_[1] = std::min(hi_[1], py_max);
+    }
+}
+
+bool PointPrefilter::point_in_roi(float x, float y) const {
+    // Even-odd crossing test
+    const auto& poly = config_.roi_polygon;
+    bool inside = false;
+    for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+        const float xi = poly[i][0], yi = poly[i][1];
+        const float xj = poly[j][0], yj = poly[j][1];
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+size_t PointPrefilter::apply(const float* in, size_t num_points, float* out) const {
+    const size_t step = static_cast<size_t>(config_.keep_every);
+    const bool use_roi = !config_.roi_polygon.empty();
+    size_t kept = 0;
+
+    // Every point is stored unconditionally at the write cursor, which only
+    // advances when the point survives. This keeps the loop branch-free and
+    // works in place because the write cursor never overtakes the read cursor.
+#if defined(PREFILTER_SSE2)
+    const __m128 lo = _mm_load_ps(lo_.data());
+    const __m128 hi = _mm_load_ps(hi_.data());
+    for (size_t i = 0; i < num_points; i += step) {
+        const __m128 p = _mm_loadu_ps(in + i * 4);
+        const __m128 ok = _mm_and_ps(_mm_cmpge_ps(p, lo), _mm_cmplt_ps(p, hi));
+        bool keep = _mm_movemask_ps(ok) == 0xF;
+        if (use_roi && keep) keep = point_in_roi(in[i * 4 + 0], in[i * 4 + 1]);
+        _mm_storeu_ps(out + kept * 4, p);
+        kept += keep;
+    }
+#elif defined(PREFILTER_NEON)
+    const float32x4_t lo = vld1q_f32(lo_.data());
+    const float32x4_t hi = vld1q_f32(hi_.data());
+    for (size_t i = 0; i < num_points; i += step) {
+        const float32x4_t p = vld1q_f32(in + i * 4);
+        const uint32x4_t ok = vandq_u32(vcgeq_f32(p, lo), vcltq_f32(p, hi));
+        bool keep = vminvq_u32(ok) != 0;
+        if (use_roi && keep) keep = point_in_roi(in[i * 4 + 0], in[i * 4 + 1]);
+        vst1q_f32(out + kept * 4, p);
+        kept += keep;
+    }
+#else
+    for (size_t i = 0; i < num_points; i += step) {
+        const float* p = in + i * 4;
+        const float x = p[0], y = p[1], z = p[2], intensity = p[3];
+        bool keep = x >= lo_[0] && x < hi_[0] && y >= lo_[1] && y < hi_[1] &&
+                    z >= lo_[2] && z < hi_[2] && intensity >= lo_[3] && intensity < hi_[3];
+        if (use_roi && keep) keep = point_in_roi(x, y);
+        std::copy(p, p + 4, out + kept * 4);
+        kept += keep;
+    }
+#endif
+
+    return kept;
+}
+
+std::vector<float> PointPrefilter::apply(const std::vector<float>& points) const {
+    const size_t num_points = points.size() / 4;
+    std::vector<float> out(points.size());
+    const size_t kept = apply(points.data(), num_points, out.data());
+    out.resize(kept * 4);
+
+    if (config_.verbose) {
+        std::cout << "Prefilter: kept " << kept << " / " << num_points << " points" << std::endl;
+    }
+    return out;
+}
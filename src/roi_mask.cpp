@@ -0,0 +1,103 @@
+#include "roi_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+RoiMask::RoiMask(int grid_x, int grid_y, float x_min, float y_min, float voxel_size_x, float voxel_size_y)
+    : grid_x_(grid_x),
+      grid_y_(grid_y),
+      x_min_(x_min),
+      y_min_(y_min),
+      voxel_size_x_(voxel_size_x),
+      voxel_size_y_(voxel_size_y) {
+    if (grid_x_ <= 0 || grid_y_ <= 0 || !(voxel_size_x_ > 0.0f) || !(voxel_size_y_ > 0.0f)) {
+        throw std::invalid_argument("RoiMask: invalid grid");
+    }
+    words_per_row_ = (static_cast<size_t>(grid_x_) + 63) / 64;
+    bits_.assign(words_per_row_ * grid_y_, 0);
+}
+
+void RoiMask::add_polygon(const Polygon& polygon) {
+    if (polygon.size() < 3) {
+        throw std::invalid_argument("RoiMask: polygon needs at least 3 points");
+    }
+    for (const auto& p : polygon) {
+        if (!std::isfinite(p[0]) || !std::isfinite(p[1])) {
+            throw std::invalid_argument("RoiMask: polygon has non-finite coordinates");
+        }
+    }
+
+    // 逐行扫描线：求各边与 cell 中心所在水平线的交点，排序后两两之间为多边形内部
+    const size_t n = polygon.size();
+    std::vector<float> crossings;
+    for (int y = 0; y < grid_y_; ++y) {
+        const float yc = y_min_ + (y + 0.5f) * voxel_size_y_;
+        crossings.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const auto& a = polygon[i];
+            const auto& b = polygon[(i + 1) % n];
+            // 半开判断，顶点恰在扫描线上时只计一次
+            if ((a[1] > yc) != (b[1] > yc)) {
+                crossings.push_back(a[0] + (yc - a[1]) * (b[0] - a[0]) / (b[1] - a[1]));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        uint64_t* row = bits_.data() + static_cast<size_t>(y) * words_per_row_;
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+            // cell 中心 x_min + (x + 0.5) * vs 落在 [x0, x1) 内
+            const float x0 = std::ceil((crossings[k] - x_min_) / voxel_size_x_ - 0.5f);
+            const float x1 = std::ceil((crossings[k + 1] - x_min_) / voxel_size_x_ - 0.5f);
+            // 先在 float 里夹到 [0, grid_x]：边远在网格外时 x0 / x1 可能超出 int 范围，直接转换是 UB
+            const float grid_w = static_cast<float>(grid_x_);
+            const int begin = static_cast<int>(std::min(grid_w, std::max(0.0f, x0)));
+            const int end = static_cast<int>(std::min(grid_w, std::max(0.0f, x1)));
+            for (int x = begin; x < end; ++x) {
+                row[x >> 6] |= uint64_t(1) << (x & 63);
+            }
+        }
+    }
+    rebuild_spans();
+}
+
+void RoiMask::clear() {
+    std::fill(bits_.begin(), bits_.end(), 0);
+    spans_.clear();
+    num_cells_ = 0;
+}
+
+void RoiMask::rebuild_spans() {
+    spans_.clear();
+    num_cells_ = 0;
+    for (int y = 0; y < grid_y_; ++y) {
+        const int32_t base = y * grid_x_;
+        int x = 0;
+        while (x < grid_x_) {
+            if (!contains(x, y)) {
+                ++x;
+                continue;
+            }
+            const int begin = x;
+            while (x < grid_x_ && contains(x, y)) ++x;
+            spans_.emplace_back(base + begin, base + x);
+            num_cells_ += static_cast<size_t>(x - begin);
+        }
+    }
+}
+
+RoiMask::Polygon RoiMask::parse_polygon(const std::string& text) {
+    Polygon polygon;
+    std::stringstream ss(text);
+    std::string vertex;
+    while (std::getline(ss, vertex, ';')) {
+        if (vertex.empty()) continue;
+        const size_t comma = vertex.find(',');
+        if (comma == std::string::npos) {
+            throw std::invalid_argument("RoiMask: bad vertex \"" + vertex + "\", expected x,y");
+        }
+        polygon.push_back({std::stof(vertex.substr(0, comma)), std::stof(vertex.substr(comma + 1))});
+    }
+    return polygon;
+}
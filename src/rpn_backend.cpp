@@ -0,0 +1,30 @@
+#include "rpn_backend.h"
+#include <stdexcept>
+
+void RPNBackend::run_sparse(
+    const SparsePillars& pillars,
+    float* box_map,
+    float* score_map) {
+    
+    if (pillars.batch_size > max_batch()) {
+        throw std::runtime_error("RPNBackend: batch_size 超过后端支持的最大 batch");
+    }
+    
+    // 第一次调用（或 batch 变大）时分配并清零，之后只清零上一帧写过的 cell。
+    // 带时序缓存的增量信息、且缓冲区里正好是它的基准帧时，只写特征变化 / 消失的 cell
+    const size_t dense_size = static_cast<size_t>(pillars.batch_size) * pillars.channels *
+                              pillars.grid_h * pillars.grid_w;
+    const bool fresh = host_input_.size() < dense_size;
+    if (fresh) {
+        host_input_.assign(dense_size, 0.0f);
+    }
+    if (!fresh && pillars.base_frame != 0 && pillars.base_frame == host_input_frame_) {
+        scatter_pillar_delta(pillars, host_input_.data());
+    } else {
+        scatter_sparse_to_dense(pillars, host_input_.data(), fresh ? nullptr : &host_input_cells_);
+    }
+    host_input_cells_ = pillars.cell_indices;
+    host_input_frame_ = pillars.frame;
+    
+    run(host_input_.data(), box_map, score_map, pillars.batch_size);
+}
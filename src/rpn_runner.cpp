@@ -1,4 +1,5 @@
 #include "rpn_runner.h"
+#include "pillar_config.h"
 #include <iostream>
 #include <cstring>
 #include <cmath>
@@ -8,13 +9,18 @@
 // 包含 lynxi SDK 头文件
 #include <lyn_api.h>
 
-RPNRunner::RPNRunner(const std::string& model_path) 
-    : engine_(nullptr), initialized_(false) {
+RPNRunner::RPNRunner(const std::string& model_path, int max_batch, int device_id) 
+    : engine_(nullptr), initialized_(false), max_batch_(max_batch) {
+    
+    if (max_batch_ < 1) {
+        throw std::invalid_argument("RPNRunner: max_batch must be >= 1");
+    }
     
     // 1. 创建 Context（如果还没有创建的话，这里假设全局已创建）
     // 注意：通常 context 应该在 main 函数中创建一次，这里为了简化先检查
     lynContext_t ctx = nullptr;
-    lynError_t err = lynCreateContext(&ctx, 0);  // chipNum = 0 表示使用默认芯片
+    // Context 绑定在创建它的线程上：多实例时每个实例要在自己的工作线程里构造 RPNRunner
+    lynError_t err = lynCreateContext(&ctx, device_id);  // chipNum = 0 表示使用默认芯片
     if (err != 0) {  // 0 表示成功
         std::cerr << "RPNRunner: 创建 Context 失败，错误码: " << err << std::endl;
         throw std::runtime_error("Failed to create lynxi context");
@@ -58,15 +64,15 @@ RPNRunner::RPNRunner(const std::string& model_path)
         throw std::runtime_error("Failed to get output size");
     }
     
-    // 5. 分配设备内存
-    err = lynMalloc((void**)&dev_input_, input_size_);
+    // 5. 分配设备内存（按 max_batch 个 batch 连续排列）
+    err = lynMalloc((void**)&dev_input_, input_size_ * max_batch_);
     if (err != 0) {
         std::cerr << "RPNRunner: 分配输入内存失败" << std::endl;
         cleanup();
         throw std::runtime_error("Failed to allocate input memory");
     }
     
-    err = lynMalloc((void**)&dev_output_, output_size_);
+    err = lynMalloc((void**)&dev_output_, output_size_ * max_batch_);
     if (err != 0) {
         std::cerr << "RPNRunner: 分配输出内存失败" << std::endl;
         cleanup();
@@ -74,7 +80,7 @@ RPNRunner::RPNRunner(const std::string& model_path)
     }
     
     // 6. 分配主机输出缓冲区
-    host_output_ = (float*)malloc(output_size_);
+    host_output_ = (float*)malloc(output_size_ * max_batch_);
     if (!host_output_) {
         cleanup();
         throw std::runtime_error("Failed to allocate host output buffer");
@@ -84,6 +90,7 @@ RPNRunner::RPNRunner(const std::string& model_path)
     std::cout << "RPNRunner: 模型加载成功" << std::endl;
     std::cout << "  输入大小: " << input_size_ << " 字节" << std::endl;
     std::cout << "  输出大小: " << output_size_ << " 字节" << std::endl;
+    std::cout << "  最大 batch: " << max_batch_ << std::endl;
 }
 
 RPNRunner::~RPNRunner() {
@@ -120,31 +127,35 @@ void RPNRunner::cleanup() {
 void RPNRunner::run(
     const float* rpn_input_map,
     float* box_map,
-    float* score_map) {
+    float* score_map,
+    int batch_size) {
     
     if (!initialized_) {
         throw std::runtime_error("RPNRunner not initialized");
     }
+    if (batch_size < 1 || batch_size > max_batch_) {
+        throw std::runtime_error("RPNRunner: batch_size 超出范围 [1, max_batch]");
+    }
     
     lynStream_t stream = (lynStream_t)stream_;
     lynModel_t model = (lynModel_t)engine_;
     
     // 1. 将输入数据拷贝到设备（同步方式，也可以异步）
     // 注意：rpn_input_map 是主机内存，需要拷贝到设备
-    lynError_t err = lynMemcpyAsync(stream, dev_input_, (void*)rpn_input_map, input_size_, 
+    lynError_t err = lynMemcpyAsync(stream, dev_input_, (void*)rpn_input_map, input_size_ * batch_size, 
                                     ClientToServer);
     if (err != 0) {
         throw std::runtime_error("Failed to copy input to device");
     }
     
     // 2. 执行推理（异步）
-    err = lynExecuteModelAsync(stream, model, dev_input_, dev_output_, 1);  // batchSize = 1
+    err = lynExecuteModelAsync(stream, model, dev_input_, dev_output_, batch_size);
     if (err != 0) {
         throw std::runtime_error("Failed to execute model");
     }
     
     // 3. 将输出数据拷贝回主机（异步）
-    err = lynMemcpyAsync(stream, host_output_, dev_output_, output_size_, ServerToClient);
+    err = lynMemcpyAsync(stream, host_output_, dev_output_, output_size_ * batch_size, ServerToClient);
     if (err != 0) {
         throw std::runtime_error("Failed to copy output from device");
     }
@@ -167,38 +178,59 @@ void RPNRunner::run(
     
     // 如果模型有多个输出tensor，需要分别处理
     // 这里假设：tensor[0] = box_map, tensor[1] = score_map
-    const size_t box_map_size = 1 * 42 * 496 * 432 * sizeof(float);
-    const size_t score_map_size = 1 * 18 * 496 * 432 * sizeof(float);
+    // 每个 batch 的输出占 output_size_ 字节，按 batch 连续排列
+    // 当前 NPU 模型是 KITTI 配置
+    using Model = KittiPillars;
+    const size_t box_map_size = static_cast<size_t>(Model::box_channels) * Model::grid_y * Model::grid_x * sizeof(float);
+    const size_t score_map_size = static_cast<size_t>(Model::score_channels) * Model::grid_y * Model::grid_x * sizeof(float);
+    
+    const size_t dir_map_size = static_cast<size_t>(Model::dir_channels) * Model::grid_y * Model::grid_x * sizeof(float);
     
+    uint64_t box_tensor_size = 0, score_tensor_size = 0, dir_tensor_size = 0;
     if (output_tensor_num >= 2) {
         // 多tensor输出：分别获取每个tensor的数据
-        uint64_t box_tensor_size = 0, score_tensor_size = 0;
         lynModelGetOutputTensorDataLenByIndex((lynModel_t)engine_, 0, &box_tensor_size);
         lynModelGetOutputTensorDataLenByIndex((lynModel_t)engine_, 1, &score_tensor_size);
+        if (output_tensor_num >= 3) {
+            // 第三个 tensor：方向分类 head
+            lynModelGetOutputTensorDataLenByIndex((lynModel_t)engine_, 2, &dir_tensor_size);
+            dir_map_.resize(max_batch_ * dir_map_size / sizeof(float));
+        }
         
         std::cout << "  Box tensor大小: " << box_tensor_size << " 字节" << std::endl;
         std::cout << "  Score tensor大小: " << score_tensor_size << " 字节" << std::endl;
+    } else if (output_size_ < (box_map_size + score_map_size)) {
+        std::cerr << "警告: 输出大小不匹配，期望: " << (box_map_size + score_map_size) 
+                  << ", 实际: " << output_size_ << std::endl;
+    }
+    
+    for (int b = 0; b < batch_size; ++b) {
+        const char* frame_output = (const char*)host_output_ + b * output_size_;
+        char* frame_box = (char*)box_map + b * box_map_size;
+        char* frame_score = (char*)score_map + b * score_map_size;
         
-        // 计算tensor在输出缓冲区中的偏移
-        uint64_t offset0 = 0;
-        uint64_t offset1 = box_tensor_size;
-        
-        std::memcpy(box_map, (char*)host_output_ + offset0, 
-                   std::min(box_map_size, static_cast<size_t>(box_tensor_size)));
-        std::memcpy(score_map, (char*)host_output_ + offset1, 
-                   std::min(score_map_size, static_cast<size_t>(score_tensor_size)));
-    } else {
-        // 单tensor输出：假设连续排列 [box_map, score_map]
-        if (output_size_ < (box_map_size + score_map_size)) {
-            std::cerr << "警告: 输出大小不匹配，期望: " << (box_map_size + score_map_size) 
-                      << ", 实际: " << output_size_ << std::endl;
-        }
-        
-        std::memcpy(box_map, host_output_, std::min(box_map_size, output_size_));
-        if (output_size_ >= box_map_size + score_map_size) {
-            std::memcpy(score_map, (char*)host_output_ + box_map_size, score_map_size);
+        if (output_tensor_num >= 2) {
+            // 计算tensor在输出缓冲区中的偏移
+            uint64_t offset0 = 0;
+            uint64_t offset1 = box_tensor_size;
+            
+            std::memcpy(frame_box, frame_output + offset0, 
+                       std::min(box_map_size, static_cast<size_t>(box_tensor_size)));
+            std::memcpy(frame_score, frame_output + offset1, 
+                       std::min(score_map_size, static_cast<size_t>(score_tensor_size)));
+            if (dir_tensor_size > 0) {
+                char* frame_dir = (char*)dir_map_.data() + b * dir_map_size;
+                std::memcpy(frame_dir, frame_output + offset1 + score_tensor_size,
+                           std::min(dir_map_size, static_cast<size_t>(dir_tensor_size)));
+            }
         } else {
-            std::memset(score_map, 0, score_map_size);
+            // 单tensor输出：假设连续排列 [box_map, score_map]
+            std::memcpy(frame_box, frame_output, std::min(box_map_size, output_size_));
+            if (output_size_ >= box_map_size + score_map_size) {
+                std::memcpy(frame_score, frame_output + box_map_size, score_map_size);
+            } else {
+                std::memset(frame_score, 0, score_map_size);
+            }
         }
     }
     
@@ -231,7 +263,7 @@ void RPNRunner::run(
     int nan_count_box = 0, inf_count_box = 0;
     int nan_count_score = 0, inf_count_score = 0;
     
-    for (size_t i = 0; i < box_map_size / sizeof(float); ++i) {
+    for (size_t i = 0; i < batch_size * box_map_size / sizeof(float); ++i) {
         float val = box_map[i];
         if (!std::isfinite(val)) {
             if (std::isnan(val)) nan_count_box++;
@@ -240,7 +272,7 @@ void RPNRunner::run(
             max_box = std::max(max_box, std::abs(val));
         }
     }
-    for (size_t i = 0; i < score_map_size / sizeof(float); ++i) {
+    for (size_t i = 0; i < batch_size * score_map_size / sizeof(float); ++i) {
         float val = score_map[i];
         if (!std::isfinite(val)) {
             if (std::isnan(val)) nan_count_score++;
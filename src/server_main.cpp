@@ -0,0 +1,208 @@
+// 常驻推理服务入口：启动时加载一次模型，之后通过 Unix domain socket 接收帧
+//
+// 用法: pointpillars_server [--socket <path>] [--instances N] [--rpn-model <path>]
+//                           [--cpu-rpn] [--pfn-weight <path>] [--pfn-bias <path>]
+//                           [--pfn-bn <prefix>] [--bundle <path>]
+//                           [--score-thr f] [--nms-thr f] [--nms-threads n] [--max-num n] [--queue n]
+//                           [--deadline-ms x] [--no-degrade] [--pillar-cache] [--sensor-affinity]
+//                           [--dynamic-voxel]
+
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "cpu_rpn.h"
+#include "engine_pool.h"
+#include "inference_server.h"
+#include "model_bundle.h"
+#ifdef WITH_LYNXI
+#include "rpn_runner.h"
+#endif
+
+namespace {
+
+InferenceServer* g_server = nullptr;
+
+void handle_signal(int) {
+    if (g_server) g_server->stop();
+}
+
+std::vector<float> load_bin(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("无法打开文件: " + path);
+    }
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    std::vector<float> buffer(size / sizeof(float));
+    file.read(reinterpret_cast<char*>(buffer.data()), size);
+    return buffer;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string project_root = "..";
+    if (!std::filesystem::exists(project_root + "/pfn_weight.bin")) {
+        project_root = ".";
+    }
+    
+    ServerConfig server_config;
+    EnginePoolConfig pool_config;
+    PipelineConfig pipeline_config;
+    std::string pfn_weight = project_root + "/pfn_weight.bin";
+    std::string pfn_bias = project_root + "/pfn_bias.bin";
+    std::string pfn_bn;
+    std::string rpn_model = project_root + "/rpn_lynxi/Net_0/apu_0/apu_x/lyn__2026-01-28-11-13-55-749707.mdl";
+    bool rpn_model_set = false;
+    std::string bundle_path;
+    int max_voxels = 0;   // 0 = 使用默认值 / 模型包中的值
+    int max_points = 0;
+    bool sensor_affinity = false;  // 没有 per-sensor 状态时按负载路由，单个传感器的帧也能并发处理
+#ifdef WITH_LYNXI
+    bool cpu_rpn = false;
+#else
+    bool cpu_rpn = true;
+#endif
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            server_config.socket_path = argv[++i];
+        } else if (arg == "--instances" && i + 1 < argc) {
+            pool_config.num_instances = std::stoi(argv[++i]);
+        } else if (arg == "--queue" && i + 1 < argc) {
+            pool_config.queue_capacity = std::stoul(argv[++i]);
+        } else if (arg == "--deadline-ms" && i + 1 < argc) {
+            pool_config.deadline_ms = std::stod(argv[++i]);
+        } else if (arg == "--no-degrade") {
+            pool_config.allow_degrade = false;
+        } else if (arg == "--pillar-cache") {
+            pipeline_config.pillar_cache = true;
+        } else if (arg == "--sensor-affinity") {
+            sensor_affinity = true;
+        } else if (arg == "--dynamic-voxel") {
+            pipeline_config.dynamic_voxelization = true;
+        } else if (arg == "--rpn-model" && i + 1 < argc) {
+            rpn_model = argv[++i];
+            rpn_model_set = true;
+        } else if (arg == "--bundle" && i + 1 < argc) {
+            bundle_path = argv[++i];
+        } else if (arg == "--cpu-rpn") {
+            cpu_rpn = true;
+        } else if (arg == "--pfn-weight" && i + 1 < argc) {
+            pfn_weight = argv[++i];
+        } else if (arg == "--pfn-bias" && i + 1 < argc) {
+            pfn_bias = argv[++i];
+        } else if (arg == "--pfn-bn" && i + 1 < argc) {
+            pfn_bn = argv[++i];
+        } else if (arg == "--score-thr" && i + 1 < argc) {
+            pipeline_config.score_thr = std::stof(argv[++i]);
+        } else if (arg == "--nms-thr" && i + 1 < argc) {
+            pipeline_config.nms_thr = std::stof(argv[++i]);
+        } else if (arg == "--nms-threads" && i + 1 < argc) {
+            pipeline_config.nms_threads = std::stoi(argv[++i]);
+        } else if (arg == "--max-num" && i + 1 < argc) {
+            pipeline_config.max_num = std::stoi(argv[++i]);
+        } else if (arg == "--roi" && i + 1 < argc) {
+            pipeline_config.roi_polygons.push_back(RoiMask::parse_polygon(argv[++i]));
+        } else if (arg == "--nms-pre" && i + 1 < argc) {
+            pipeline_config.nms_pre = std::stoi(argv[++i]);
+        } else if (arg == "--max-voxels" && i + 1 < argc) {
+            max_voxels = std::stoi(argv[++i]);
+        } else if (arg == "--max-points" && i + 1 < argc) {
+            max_points = std::stoi(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "用法: " << argv[0] << " [选项]\n"
+                      << "选项:\n"
+                      << "  --socket <path>       监听的 Unix socket (默认: /tmp/pointpillars.sock)\n"
+                      << "  --instances <int>     Pipeline 实例数 (默认: 1)\n"
+                      << "  --queue <int>         每个实例的排队帧数上限 (默认: 4)\n"
+                      << "  --deadline-ms <float> 实时调度: 每帧截止时间，来不及则降级或丢帧 (默认: 0 关闭)\n"
+                      << "  --no-degrade          实时调度时不降级，只丢弃过期帧\n"
+                      << "  --pillar-cache        时序 pillar 缓存: 复用点内容不变的 pillar 特征（静止安装）；\n"
+                      << "                         需要同一传感器的帧固定在一个实例上，隐含 --sensor-affinity\n"
+                      << "  --sensor-affinity     按 sensor_id 固定路由到实例（同一传感器串行处理）；默认每帧发给\n"
+                      << "                         负载最小的实例，单个传感器的帧也能在多个实例上并发处理\n"
+                      << "  --dynamic-voxel       动态体素化: 点直接进 PFN，不填充、不截断 pillar 点数\n"
+                      << "  --rpn-model <path>    RPN模型路径\n"
+                      << "  --cpu-rpn             使用 CPU 替身 RPN（无 NPU 时测试用）\n"
+                      << "  --pfn-weight <path>   PFN权重 (默认: pfn_weight.bin)\n"
+                      << "  --pfn-bias <path>     PFN偏置 (默认: pfn_bias.bin)\n"
+                      << "  --pfn-bn <prefix>     PFN BatchNorm 参数 <prefix>_{gamma,beta,mean,var}.bin (默认: 不加载)\n"
+                      << "  --bundle <path>       模型包：PFN 权重、体素 / decode 配置和 RPN 路径，所有实例共享同一份只读映射\n"
+                      << "  --score-thr <float>   分数阈值 (默认: 0.3)\n"
+                      << "  --nms-thr <float>     NMS阈值 (默认: 0.01)\n"
+                      << "  --nms-threads <int>   NMS 线程数，1 为串行，0 为硬件线程数 (默认: 1)\n"
+                      << "  --max-num <int>       最大检测数 (默认: 100)\n"
+                      << "  --nms-pre <int>       只把 score 最高的 n 个候选送进 NMS (默认: 0 不限)\n"
+                      << "  --max-voxels <int>    最大 pillar 数，覆盖模型包中的值 (默认: 40000)\n"
+                      << "  --max-points <int>    每个 pillar 最多点数，覆盖模型包中的值 (默认: 32)\n"
+                      << "  --roi <x,y;x,y;...>   BEV 感兴趣区域多边形（米），可重复，取并集 (默认: 整个网格)\n";
+            return 0;
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    try {
+        PFN_CPU pfn;
+        if (!bundle_path.empty()) {
+            if (!pfn_bn.empty()) {
+                throw std::invalid_argument("--pfn-bn 不能与 --bundle 同时使用（BN 在打包时折叠）");
+            }
+            ModelBundle bundle(bundle_path);
+            pipeline_config.voxel = bundle.voxel_config(pipeline_config.voxel);
+            pipeline_config.decode = bundle.decode_config(pipeline_config.decode);
+            pfn.use_packed_weights(bundle.pfn_weights());
+            if (!rpn_model_set && !bundle.rpn_model_path().empty()) {
+                rpn_model = bundle.rpn_model_path();
+            }
+            std::cout << "模型包: " << bundle_path << " (v" << bundle.version() << ")" << std::endl;
+        } else {
+            pfn.pfn_weights = load_bin(pfn_weight);
+            pfn.pfn_bias = load_bin(pfn_bias);
+            if (!pfn_bn.empty()) {
+                pfn.fold_batchnorm(load_bin(pfn_bn + "_gamma.bin"), load_bin(pfn_bn + "_beta.bin"),
+                                   load_bin(pfn_bn + "_mean.bin"), load_bin(pfn_bn + "_var.bin"));
+            }
+        }
+        if (max_voxels > 0) pipeline_config.voxel.max_voxels = max_voxels;
+        if (max_points > 0) pipeline_config.voxel.max_num_points = max_points;
+        server_config.num_point_features = pipeline_config.voxel.num_point_features;
+        // pillar 缓存按实例保存上一帧，必须让同一传感器的帧落在同一实例上
+        pool_config.sensor_affinity = sensor_affinity || pipeline_config.pillar_cache;
+        
+        EnginePool pool(pool_config, [&](int instance) -> std::unique_ptr<Pipeline> {
+            std::unique_ptr<RPNBackend> backend;
+            if (cpu_rpn) {
+                CpuRPNConfig rpn_config;
+                rpn_config.max_batch = 1;
+                backend = std::make_unique<CpuRPN>(rpn_config);
+            } else {
+#ifdef WITH_LYNXI
+                backend = std::make_unique<RPNRunner>(rpn_model, 1);
+#endif
+            }
+            std::cout << "✓ 实例 " << instance << " 就绪" << std::endl;
+            return std::make_unique<Pipeline>(pipeline_config, pfn, std::move(backend));
+        });
+        
+        InferenceServer server(server_config, pool);
+        g_server = &server;
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+        server.run();
+        g_server = nullptr;
+        
+        std::cout << server.stats_json() << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
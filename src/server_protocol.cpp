@@ -0,0 +1,118 @@
+#include "server_protocol.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pp_server {
+
+namespace {
+
+// 读满 size 字节；在消息开头遇到 EOF 返回 false
+bool read_exact(int fd, void* buf, size_t size, bool allow_eof) {
+    char* p = static_cast<char*>(buf);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::recv(fd, p + done, size - done, 0);
+        if (n == 0) {
+            if (allow_eof && done == 0) return false;
+            throw std::runtime_error("连接在消息中途被关闭");
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("recv 失败: ") + std::strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void write_exact(int fd, const void* buf, size_t size) {
+    const char* p = static_cast<const char*>(buf);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::send(fd, p + done, size - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("send 失败: ") + std::strerror(errno));
+        }
+        done += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+bool read_message(int fd, MessageHeader& header, std::vector<char>& payload) {
+    if (!read_exact(fd, &header, sizeof(header), true)) {
+        return false;
+    }
+    if (header.magic != kMagic || header.version != kVersion) {
+        throw std::runtime_error("协议错误: magic/version 不匹配");
+    }
+    if (header.payload_bytes > kMaxPayloadBytes) {
+        throw std::runtime_error("协议错误: 负载过大 (" + std::to_string(header.payload_bytes) + " 字节)");
+    }
+    payload.resize(header.payload_bytes);
+    if (header.payload_bytes > 0) {
+        read_exact(fd, payload.data(), payload.size(), false);
+    }
+    return true;
+}
+
+void write_message(int fd, const MessageHeader& header, const void* payload) {
+    // 头和负载合并成一次 send，避免小包延迟
+    std::vector<char> buffer(sizeof(header) + header.payload_bytes);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    if (header.payload_bytes > 0) {
+        std::memcpy(buffer.data() + sizeof(header), payload, header.payload_bytes);
+    }
+    write_exact(fd, buffer.data(), buffer.size());
+}
+
+std::vector<DetectionRecord> to_records(const std::vector<Box3D>& boxes) {
+    std::vector<DetectionRecord> records(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        const Box3D& b = boxes[i];
+        records[i] = {b.x, b.y, b.z, b.w, b.l, b.h, b.rot, b.score, b.label};
+    }
+    return records;
+}
+
+std::vector<Box3D> from_records(const char* payload, uint32_t count) {
+    std::vector<Box3D> boxes(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        DetectionRecord r;
+        std::memcpy(&r, payload + i * sizeof(DetectionRecord), sizeof(r));
+        Box3D& b = boxes[i];
+        b.x = r.x; b.y = r.y; b.z = r.z;
+        b.w = r.w; b.l = r.l; b.h = r.h;
+        b.rot = r.rot;
+        b.score = r.score;
+        b.label = r.label;
+    }
+    return boxes;
+}
+
+int connect_unix(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket 路径过长: " + path);
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket 失败: ") + std::strerror(errno));
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("连接 " + path + " 失败: " + std::strerror(err));
+    }
+    return fd;
+}
+
+} // namespace pp_server
@@ -0,0 +1,148 @@
+#include "sweep_accumulator.h"
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SWEEP_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SWEEP_NEON 1
+#endif
+
+namespace {
+
+// Rigid transform newest_from_sweep = inverse(newest_pose) * sweep_pose,
+// returned as a row-major 3x4 matrix
+std::array<float, 12> relative_transform(const std::array<float, 16>& newest,
+                                         const std::array<float, 16>& sweep) {
+    // inverse of [R | t] is [R^T | -R^T t]
+    double inv[3][4];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            inv[r][c] = newest[c * 4 + r];
+        }
+        inv[r][3] = -(inv[r][0] * newest[3] + inv[r][1] * newest[7] + inv[r][2] * newest[11]);
+    }
+    std::array<float, 12> m;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            double v = c == 3 ? inv[r][3] : 0.0;
+            for (int k = 0; k < 3; ++k) {
+                v += inv[r][k] * sweep[k * 4 + c];
+            }
+            m[r * 4 + c] = static_cast<float>(v);
+        }
+    }
+    return m;
+}
+
+// out[i] = [m * (x, y, z, 1), intensity, lag] for [n, 4] input points
+void transform_points(const float* in, size_t n, const std::array<float, 12>& m,
+                      float lag, float* out) {
+#if defined(SWEEP_SSE2)
+    // Columns of the 3x4 matrix, lane 3 carries the intensity through
+    const __m128 c0 = _mm_setr_ps(m[0], m[4], m[8], 0.0f);
+    const __m128 c1 = _mm_setr_ps(m[1], m[5], m[9], 0.0f);
+    const __m128 c2 = _mm_setr_ps(m[2], m[6], m[10], 0.0f);
+    const __m128 c3 = _mm_setr_ps(m[3], m[7], m[11], 0.0f);
+    const __m128 e3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for (size_t i = 0; i < n; ++i) {
+        const __m128 p = _mm_loadu_ps(in + i * 4);
+        __m128 r = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(e3, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_storeu_ps(out + i * 5, r);
+        out[i * 5 + 4] = lag;
+    }
+#elif defined(SWEEP_NEON)
+    const float32x4_t c0 = {m[0], m[4], m[8], 0.0f};
+    const float32x4_t c1 = {m[1], m[5], m[9], 0.0f};
+    const float32x4_t c2 = {m[2], m[6], m[10], 0.0f};
+    const float32x4_t c3 = {m[3], m[7], m[11], 0.0f};
+    const float32x4_t e3 = {0.0f, 0.0f, 0.0f, 1.0f};
+    for (size_t i = 0; i < n; ++i) {
+        const float32x4_t p = vld1q_f32(in + i * 4);
+        float32x4_t r = vfmaq_laneq_f32(c3, c0, p, 0);
+        r = vfmaq_laneq_f32(r, c1, p, 1);
+        r = vfmaq_laneq_f32(r, c2, p, 2);
+        r = vfmaq_laneq_f32(r, e3, p, 3);
+        vst1q_f32(out + i * 5, r);
+        out[i * 5 + 4] = lag;
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        const float x = in[i * 4 + 0], y = in[i * 4 + 1], z = in[i * 4 + 2];
+        out[i * 5 + 0] = m[0] * x + m[1] * y + m[2] * z + m[3];
+        out[i * 5 + 1] = m[4] * x + m[5] * y + m[6] * z + m[7];
+        out[i * 5 + 2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+        out[i * 5 + 3] = in[i * 4 + 3];
+        out[i * 5 + 4] = lag;
+    }
+#endif
+}
+
+} // namespace
+
+SweepAccumulator::SweepAccumulator(const SweepConfig& config) : config_(config) {
+    if (config_.max_sweeps < 1) {
+        throw std::invalid_argument("SweepConfig: max_sweeps must be >= 1");
+    }
+    ring_.resize(config_.max_sweeps);
+    spans_.reserve(config_.max_sweeps);
+}
+
+void SweepAccumulator::push(const float* points, size_t num_points,
+                            const std::array<float, 16>& pose, double timestamp) {
+    head_ = (head_ + 1) % config_.max_sweeps;
+    count_ = std::min(count_ + 1, config_.max_sweeps);
+
+    // assign() keeps the slot's capacity, so a warm ring does not allocate
+    Sweep& sweep = ring_[head_];
+    sweep.raw.assign(points, points + num_points * 4);
+    sweep.out.resize(num_points * 5);
+    sweep.pose = pose;
+    sweep.timestamp = timestamp;
+    sweep.num_points = num_points;
+    sweep.out_lag = -1.0f;  // output is stale
+}
+
+const std::vector<PointSpan>& SweepAccumulator::accumulate() {
+    spans_.clear();
+    if (count_ == 0) {
+        return spans_;
+    }
+
+    const Sweep& newest = ring_[head_];
+    for (int k = 0; k < count_; ++k) {
+        Sweep& sweep = ring_[(head_ - k + config_.max_sweeps) % config_.max_sweeps];
+        const double lag = newest.timestamp - sweep.timestamp;
+        if (lag > config_.max_time_lag) {
+            break;  // the rest are even older
+        }
+
+        const auto m = relative_transform(newest.pose, sweep.pose);
+        const float lag_f = static_cast<float>(lag);
+        if (sweep.out_lag < 0.0f || m != sweep.out_transform) {
+            transform_points(sweep.raw.data(), sweep.num_points, m, lag_f, sweep.out.data());
+        } else if (lag_f != sweep.out_lag) {
+            // Ego pose unchanged relative to this sweep (static platform):
+            // the geometry is still valid, only the lag channel moves
+            for (size_t i = 0; i < sweep.num_points; ++i) {
+                sweep.out[i * 5 + 4] = lag_f;
+            }
+        }
+        sweep.out_transform = m;
+        sweep.out_lag = lag_f;
+
+        spans_.push_back({sweep.out.data(), sweep.num_points});
+    }
+    return spans_;
+}
+
+void SweepAccumulator::reset() {
+    head_ = -1;
+    count_ = 0;
+    spans_.clear();
+}
@@ -0,0 +1,369 @@
+#include "vec_math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(VECMATH_LIBM_REFERENCE)
+
+// Reference build (tests only): the same interface evaluated element-wise
+// with float libm, to compare end-to-end results against the kernels below
+namespace vecmath {
+
+void exp(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = std::exp(in[i]);
+}
+
+void sigmoid(const float* in, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = 1.0f / (1.0f + std::exp(-in[i]));
+}
+
+void sincos(const float* in, float* sin_out, float* cos_out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        sin_out[i] = std::sin(in[i]);
+        cos_out[i] = std::cos(in[i]);
+    }
+}
+
+void max3(const float* a, const float* b, const float* c, float* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) out[i] = std::max(std::max(a[i], b[i]), c[i]);
+}
+
+const char* isa_name() { return "libm"; }
+
+} // namespace vecmath
+
+#else
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define VECMATH_AVX512 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define VECMATH_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VECMATH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VECMATH_NEON 1
+#endif
+
+namespace {
+
+// Each ISA provides the same small set of lane-wise operations; the kernels
+// below are written once against this interface. V = float lanes,
+// I = int32 lanes, M = lane mask.
+
+struct ScalarOps {
+    using V = float;
+    using I = int32_t;
+    using M = bool;
+    static constexpr size_t width = 1;
+
+    static V load(const float* p) { return *p; }
+    static void store(float* p, V v) { *p = v; }
+    static V set1(float x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static uint32_t bits(V v) { uint32_t u; std::memcpy(&u, &v, 4); return u; }
+    static V from_bits(uint32_t u) { V v; std::memcpy(&v, &u, 4); return v; }
+    static V abs(V v) { return from_bits(bits(v) & 0x7FFFFFFFu); }
+    static I sign_bit(V v) { return static_cast<I>(bits(v) & 0x80000000u); }
+    static V xor_sign(V v, I s) { return from_bits(bits(v) ^ static_cast<uint32_t>(s)); }
+    static I cvt_trunc(V v) { return static_cast<I>(v); }
+    // round to nearest even, like cvtps_epi32 under the default MXCSR mode
+    static I cvt_round(V v) { return static_cast<I>(std::rint(v)); }
+    static V cvt(I i) { return static_cast<V>(i); }
+    static I iadd(I a, I b) { return a + b; }
+    static I iand(I a, I b) { return a & b; }
+    static I iandnot(I a, I b) { return ~a & b; }
+    static I ixor(I a, I b) { return a ^ b; }
+    static I iset1(int32_t x) { return x; }
+    static I shl(I a, int n) { return static_cast<I>(static_cast<uint32_t>(a) << n); }
+    static V as_float(I i) { return from_bits(static_cast<uint32_t>(i)); }
+    static M ieq(I a, I b) { return a == b; }
+    static V select(M m, V a, V b) { return m ? a : b; }
+};
+
+#if defined(VECMATH_AVX512)
+struct SimdOps {
+    using V = __m512;
+    using I = __m512i;
+    using M = __mmask16;
+    static constexpr size_t width = 16;
+
+    static V load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+    static V set1(float x) { return _mm512_set1_ps(x); }
+    static V add(V a, V b) { return _mm512_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm512_div_ps(a, b); }
+    static V min(V a, V b) { return _mm512_min_ps(a, b); }
+    static V max(V a, V b) { return _mm512_max_ps(a, b); }
+    static V abs(V v) {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(v), _mm512_set1_epi32(0x7FFFFFFF)));
+    }
+    static I sign_bit(V v) {
+        return _mm512_and_si512(_mm512_castps_si512(v), _mm512_set1_epi32(static_cast<int>(0x80000000u)));
+    }
+    static V xor_sign(V v, I s) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), s)); }
+    static I cvt_trunc(V v) { return _mm512_cvttps_epi32(v); }
+    static I cvt_round(V v) { return _mm512_cvtps_epi32(v); }
+    static V cvt(I i) { return _mm512_cvtepi32_ps(i); }
+    static I iadd(I a, I b) { return _mm512_add_epi32(a, b); }
+    static I iand(I a, I b) { return _mm512_and_si512(a, b); }
+    static I iandnot(I a, I b) { return _mm512_andnot_si512(a, b); }
+    static I ixor(I a, I b) { return _mm512_xor_si512(a, b); }
+    static I iset1(int32_t x) { return _mm512_set1_epi32(x); }
+    static I shl(I a, int n) { return _mm512_slli_epi32(a, static_cast<unsigned>(n)); }
+    static V as_float(I i) { return _mm512_castsi512_ps(i); }
+    static M ieq(I a, I b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    static V select(M m, V a, V b) { return _mm512_mask_blend_ps(m, b, a); }
+};
+#define VECMATH_ISA "avx512"
+#define VECMATH_ISA_SIMD 1
+#elif defined(VECMATH_AVX2)
+struct SimdOps {
+    using V = __m256;
+    using I = __m256i;
+    using M = __m256;
+    static constexpr size_t width = 8;
+
+    static V load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V set1(float x) { return _mm256_set1_ps(x); }
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V abs(V v) { return _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF))); }
+    static I sign_bit(V v) {
+        return _mm256_and_si256(_mm256_castps_si256(v), _mm256_set1_epi32(static_cast<int>(0x80000000u)));
+    }
+    static V xor_sign(V v, I s) { return _mm256_xor_ps(v, _mm256_castsi256_ps(s)); }
+    static I cvt_trunc(V v) { return _mm256_cvttps_epi32(v); }
+    static I cvt_round(V v) { return _mm256_cvtps_epi32(v); }
+    static V cvt(I i) { return _mm256_cvtepi32_ps(i); }
+    static I iadd(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I iand(I a, I b) { return _mm256_and_si256(a, b); }
+    static I iandnot(I a, I b) { return _mm256_andnot_si256(a, b); }
+    static I ixor(I a, I b) { return _mm256_xor_si256(a, b); }
+    static I iset1(int32_t x) { return _mm256_set1_epi32(x); }
+    static I shl(I a, int n) { return _mm256_slli_epi32(a, n); }
+    static V as_float(I i) { return _mm256_castsi256_ps(i); }
+    static M ieq(I a, I b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)); }
+    static V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+};
+#define VECMATH_ISA "avx2"
+#define VECMATH_ISA_SIMD 1
+#elif defined(VECMATH_SSE2)
+struct SimdOps {
+    using V = __m128;
+    using I = __m128i;
+    using M = __m128;
+    static constexpr size_t width = 4;
+
+    static V load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+    static V set1(float x) { return _mm_set1_ps(x); }
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V min(V a, V b) { return _mm_min_ps(a, b); }
+    static V max(V a, V b) { return _mm_max_ps(a, b); }
+    static V abs(V v) { return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF))); }
+    static I sign_bit(V v) {
+        return _mm_and_si128(_mm_castps_si128(v), _mm_set1_epi32(static_cast<int>(0x80000000u)));
+    }
+    static V xor_sign(V v, I s) { return _mm_xor_ps(v, _mm_castsi128_ps(s)); }
+    static I cvt_trunc(V v) { return _mm_cvttps_epi32(v); }
+    static I cvt_round(V v) { return _mm_cvtps_epi32(v); }
+    static V cvt(I i) { return _mm_cvtepi32_ps(i); }
+    static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+    static I iand(I a, I b) { return _mm_and_si128(a, b); }
+    static I iandnot(I a, I b) { return _mm_andnot_si128(a, b); }
+    static I ixor(I a, I b) { return _mm_xor_si128(a, b); }
+    static I iset1(int32_t x) { return _mm_set1_epi32(x); }
+    static I shl(I a, int n) { return _mm_slli_epi32(a, n); }
+    static V as_float(I i) { return _mm_castsi128_ps(i); }
+    static M ieq(I a, I b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b)); }
+    static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+#define VECMATH_ISA "sse2"
+#define VECMATH_ISA_SIMD 1
+#elif defined(VECMATH_NEON)
+struct SimdOps {
+    using V = float32x4_t;
+    using I = int32x4_t;
+    using M = uint32x4_t;
+    static constexpr size_t width = 4;
+
+    static V load(const float* p) { return vld1q_f32(p); }
+    static void store(float* p, V v) { vst1q_f32(p, v); }
+    static V set1(float x) { return vdupq_n_f32(x); }
+    static V add(V a, V b) { return vaddq_f32(a, b); }
+    static V sub(V a, V b) { return vsubq_f32(a, b); }
+    static V mul(V a, V b) { return vmulq_f32(a, b); }
+    static V div(V a, V b) { return vdivq_f32(a, b); }
+    static V min(V a, V b) { return vminq_f32(a, b); }
+    static V max(V a, V b) { return vmaxq_f32(a, b); }
+    static V abs(V v) { return vabsq_f32(v); }
+    static I sign_bit(V v) {
+        return vandq_s32(vreinterpretq_s32_f32(v), vdupq_n_s32(static_cast<int32_t>(0x80000000u)));
+    }
+    static V xor_sign(V v, I s) { return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(v), s)); }
+    static I cvt_trunc(V v) { return vcvtq_s32_f32(v); }
+    static I cvt_round(V v) { return vcvtnq_s32_f32(v); }
+    static V cvt(I i) { return vcvtq_f32_s32(i); }
+    static I iadd(I a, I b) { return vaddq_s32(a, b); }
+    static I iand(I a, I b) { return vandq_s32(a, b); }
+    static I iandnot(I a, I b) { return vbicq_s32(b, a); }
+    static I ixor(I a, I b) { return veorq_s32(a, b); }
+    static I iset1(int32_t x) { return vdupq_n_s32(x); }
+    static I shl(I a, int n) { return vshlq_s32(a, vdupq_n_s32(n)); }
+    static V as_float(I i) { return vreinterpretq_f32_s32(i); }
+    static M ieq(I a, I b) { return vceqq_s32(a, b); }
+    static V select(M m, V a, V b) { return vbslq_f32(m, a, b); }
+};
+#define VECMATH_ISA "neon"
+#define VECMATH_ISA_SIMD 1
+#else
+#define VECMATH_ISA "scalar"
+#endif
+
+// ---- exp -----------------------------------------------------------------
+// x = n*ln2 + r, |r| <= ln2/2; exp(r) by a degree-7 minimax polynomial
+// (Cephes expf coefficients), then scale by 2^n built in the exponent bits.
+template <class S>
+typename S::V exp_lanes(typename S::V x) {
+    using V = typename S::V;
+    // clamp keeps n inside [-126, 127] so 2^n is always a normal float
+    x = S::min(x, S::set1(88.0f));
+    x = S::max(x, S::set1(-87.0f));
+
+    const V fn = S::cvt(S::cvt_round(S::mul(x, S::set1(1.44269504088896341f))));
+    // ln2 split in two so n*ln2_hi is exact
+    V r = S::sub(x, S::mul(fn, S::set1(0.693359375f)));
+    r = S::sub(r, S::mul(fn, S::set1(-2.12194440e-4f)));
+
+    V p = S::set1(1.9875691500e-4f);
+    p = S::add(S::mul(p, r), S::set1(1.3981999507e-3f));
+    p = S::add(S::mul(p, r), S::set1(8.3334519073e-3f));
+    p = S::add(S::mul(p, r), S::set1(4.1665795894e-2f));
+    p = S::add(S::mul(p, r), S::set1(1.6666665459e-1f));
+    p = S::add(S::mul(p, r), S::set1(5.0000001201e-1f));
+    V y = S::add(S::add(S::mul(S::mul(p, r), r), r), S::set1(1.0f));
+
+    // 2^n with n in [-126, 127]
+    const V pow2n = S::as_float(S::shl(S::iadd(S::cvt_round(fn), S::iset1(127)), 23));
+    return S::mul(y, pow2n);
+}
+
+template <class S>
+typename S::V sigmoid_lanes(typename S::V x) {
+    const auto one = S::set1(1.0f);
+    return S::div(one, S::add(one, exp_lanes<S>(S::sub(S::set1(0.0f), x))));
+}
+
+// ---- sincos --------------------------------------------------------------
+// Cephes sinf/cosf: reduce |x| to [-pi/4, pi/4] by the nearest even multiple
+// of pi/4 (three-part Cody-Waite constant), evaluate both polynomials, then
+// swap and negate by octant.
+template <class S>
+void sincos_lanes(typename S::V x, typename S::V& s, typename S::V& c) {
+    using V = typename S::V;
+    using I = typename S::I;
+
+    I sign_sin = S::sign_bit(x);
+    x = S::abs(x);
+
+    I j = S::cvt_trunc(S::mul(x, S::set1(1.27323954473516f)));  // 4/pi
+    j = S::iand(S::iadd(j, S::iset1(1)), S::iset1(~1));
+    const V y = S::cvt(j);
+
+    // sin changes sign in octants 4..7, cos in octants 2..5
+    sign_sin = S::ixor(sign_sin, S::shl(S::iand(j, S::iset1(4)), 29));
+    const I sign_cos = S::shl(S::iandnot(S::iadd(j, S::iset1(-2)), S::iset1(4)), 29);
+    // octants 2 and 6: the sin polynomial gives cos and vice versa
+    const auto use_cos_poly = S::ieq(S::iand(j, S::iset1(2)), S::iset1(2));
+
+    x = S::sub(x, S::mul(y, S::set1(0.78515625f)));
+    x = S::sub(x, S::mul(y, S::set1(2.4187564849853515625e-4f)));
+    x = S::sub(x, S::mul(y, S::set1(3.77489497744594108e-8f)));
+    const V z = S::mul(x, x);
+
+    V pc = S::set1(2.443315711809948e-5f);
+    pc = S::add(S::mul(pc, z), S::set1(-1.388731625493765e-3f));
+    pc = S::add(S::mul(pc, z), S::set1(4.166664568298827e-2f));
+    pc = S::mul(S::mul(pc, z), z);
+    pc = S::add(S::sub(pc, S::mul(z, S::set1(0.5f))), S::set1(1.0f));
+
+    V ps = S::set1(-1.9515295891e-4f);
+    ps = S::add(S::mul(ps, z), S::set1(8.3321608736e-3f));
+    ps = S::add(S::mul(ps, z), S::set1(-1.6666654611e-1f));
+    ps = S::add(S::mul(S::mul(ps, z), x), x);
+
+    s = S::xor_sign(S::select(use_cos_poly, pc, ps), sign_sin);
+    c = S::xor_sign(S::select(use_cos_poly, ps, pc), sign_cos);
+}
+
+} // namespace
+
+namespace vecmath {
+
+void exp(const float* in, float* out, size_t n) {
+    size_t i = 0;
+#ifdef VECMATH_ISA_SIMD
+    for (; i + SimdOps::width <= n; i += SimdOps::width)
+        SimdOps::store(out + i, exp_lanes<SimdOps>(SimdOps::load(in + i)));
+#endif
+    for (; i < n; ++i) out[i] = exp_lanes<ScalarOps>(in[i]);
+}
+
+void sigmoid(const float* in, float* out, size_t n) {
+    size_t i = 0;
+#ifdef VECMATH_ISA_SIMD
+    for (; i + SimdOps::width <= n; i += SimdOps::width)
+        SimdOps::store(out + i, sigmoid_lanes<SimdOps>(SimdOps::load(in + i)));
+#endif
+    for (; i < n; ++i) out[i] = sigmoid_lanes<ScalarOps>(in[i]);
+}
+
+void sincos(const float* in, float* sin_out, float* cos_out, size_t n) {
+    size_t i = 0;
+#ifdef VECMATH_ISA_SIMD
+    for (; i + SimdOps::width <= n; i += SimdOps::width) {
+        SimdOps::V s, c;
+        sincos_lanes<SimdOps>(SimdOps::load(in + i), s, c);
+        SimdOps::store(sin_out + i, s);
+        SimdOps::store(cos_out + i, c);
+    }
+#endif
+    for (; i < n; ++i) sincos_lanes<ScalarOps>(in[i], sin_out[i], cos_out[i]);
+}
+
+void max3(const float* a, const float* b, const float* c, float* out, size_t n) {
+    size_t i = 0;
+#ifdef VECMATH_ISA_SIMD
+    for (; i + SimdOps::width <= n; i += SimdOps::width) {
+        SimdOps::store(out + i, SimdOps::max(SimdOps::max(SimdOps::load(a + i), SimdOps::load(b + i)),
+                                             SimdOps::load(c + i)));
+    }
+#endif
+    for (; i < n; ++i) out[i] = ScalarOps::max(ScalarOps::max(a[i], b[i]), c[i]);
+}
+
+const char* isa_name() { return VECMATH_ISA; }
+
+} // namespace vecmath
+
+#endif // VECMATH_LIBM_REFERENCE
@@ -1,8 +1,37 @@
 #include "voxelizer.h"
+#include "pillar_config.h"
 #include <cmath>
 #include <algorithm>
 #include <iostream>
-#include <unordered_map>
+#include <stdexcept>
+
+namespace {
+
+// Calls fn(point, index) for every point of every span, in order
+template <typename Fn>
+void for_each_point(const std::vector<PointSpan>& spans, int num_features, Fn&& fn) {
+    int index = 0;
+    for (const auto& span : spans) {
+        for (size_t s = 0; s < span.num_points; ++s) {
+            fn(span.data + s * num_features, index++);
+        }
+    }
+}
+
+// Interleaves the low 16 bits of x and y into a Z-order code (x in the even bits)
+inline uint32_t morton2d(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+} // namespace
 
 Voxelizer::Voxelizer(const VoxelConfig& config) : config_(config) {
     // Calculate grid size based on point cloud range and voxel size
@@ -16,8 +45,37 @@ Voxelizer::Voxelizer(const VoxelConfig& config) : config_(config) {
         std::ceil((config_.point_cloud_range[5] - config_.point_cloud_range[2]) / config_.voxel_size[2])
     );
     
-    std::cout << "Voxelizer initialized with grid size: [" 
-              << grid_size_[0] << ", " << grid_size_[1] << ", " << grid_size_[2] << "]" << std::endl;
+    if (config_.num_point_features < 3) {
+        throw std::invalid_argument("VoxelConfig: num_point_features must be >= 3");
+    }
+    // VoxelData stores uint8 counts, uint16 x/y and no z
+    if (config_.max_num_points < 1 || config_.max_num_points > 255) {
+        throw std::invalid_argument("VoxelConfig: max_num_points must be in [1, 255]");
+    }
+    if (grid_size_[0] > 65536 || grid_size_[1] > 65536) {
+        throw std::invalid_argument("VoxelConfig: BEV grid must be at most 65536 cells per side");
+    }
+    if (grid_size_[2] != 1) {
+        throw std::invalid_argument("VoxelConfig: pillars must span the z range with a single voxel");
+    }
+    // NearFirst converts range / distance_band to an integer band index
+    if (config_.budget == VoxelBudget::NearFirst && !(config_.distance_band > 0.0f)) {
+        throw std::invalid_argument("VoxelConfig: distance_band must be > 0 for the NearFirst budget");
+    }
+    
+    cell_slot_.assign(static_cast<size_t>(grid_size_[0]) * grid_size_[1] * grid_size_[2], -1);
+    
+    if (config_.verbose) {
+        std::cout << "Voxelizer initialized with grid size: [" 
+                  << grid_size_[0] << ", " << grid_size_[1] << ", " << grid_size_[2] << "]" << std::endl;
+    }
+}
+
+void Voxelizer::set_max_voxels(int max_voxels) {
+    if (max_voxels < 1) {
+        throw std::invalid_argument("Voxelizer: max_voxels must be >= 1");
+    }
+    config_.max_voxels = max_voxels;
 }
 
 std::array<int, 3> Voxelizer::point_to_grid_coords(float x, float y, float z) {
@@ -37,83 +95,406 @@ std::array<int, 3> Voxelizer::point_to_grid_coords(float x, float y, float z) {
     return coords;
 }
 
+int Voxelizer::select_voxels(int num_occupied) {
+    const int num_voxels = std::min(num_occupied, config_.max_voxels);
+    slot_voxel_.resize(num_occupied);
+    
+    if (num_occupied <= num_voxels || config_.budget == VoxelBudget::FirstArrival) {
+        for (int slot = 0; slot < num_occupied; ++slot) {
+            slot_voxel_[slot] = slot < num_voxels ? slot : -1;
+        }
+        return num_voxels;
+    }
+    
+    // Rank every occupied cell, then take the top max_voxels with a linear
+    // time selection. Ties are broken by arrival so the result is stable.
+    slot_priority_.resize(num_occupied);
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        int64_t priority = slot_count_[slot];
+        if (config_.budget == VoxelBudget::NearFirst) {
+            const int voxel_key = slot_cell_[slot];
+            const int y_coord = (voxel_key / grid_size_[2]) % grid_size_[1];
+            const int x_coord = voxel_key / (grid_size_[1] * grid_size_[2]);
+            const float cx = (x_coord + 0.5f) * config_.voxel_size[0] + config_.point_cloud_range[0];
+            const float cy = (y_coord + 0.5f) * config_.voxel_size[1] + config_.point_cloud_range[1];
+            const int64_t band = static_cast<int64_t>(std::sqrt(cx * cx + cy * cy) / config_.distance_band);
+            priority = -band * (int64_t(1) << 32) + priority;
+        }
+        slot_priority_[slot] = priority;
+    }
+    
+    slot_order_.resize(num_occupied);
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        slot_order_[slot] = slot;
+    }
+    std::nth_element(slot_order_.begin(), slot_order_.begin() + num_voxels, slot_order_.end(),
+                     [this](int a, int b) {
+                         if (slot_priority_[a] != slot_priority_[b]) {
+                             return slot_priority_[a] > slot_priority_[b];
+                         }
+                         return a < b;
+                     });
+    
+    // Keep the surviving voxels in arrival order
+    std::fill(slot_voxel_.begin(), slot_voxel_.end(), -1);
+    for (int k = 0; k < num_voxels; ++k) {
+        slot_voxel_[slot_order_[k]] = 0;
+    }
+    int voxel_idx = 0;
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        if (slot_voxel_[slot] == 0) {
+            slot_voxel_[slot] = voxel_idx++;
+        }
+    }
+    return num_voxels;
+}
+
+void Voxelizer::order_voxels(int num_occupied, int num_voxels) {
+    if (config_.order == PillarOrder::Arrival || num_voxels < 2) {
+        return;
+    }
+    
+    order_items_.resize(num_voxels);
+    uint32_t max_key = 0;
+    int n = 0;
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        if (slot_voxel_[slot] < 0) {
+            continue;
+        }
+        const int voxel_key = slot_cell_[slot];
+        const uint32_t y = (voxel_key / grid_size_[2]) % grid_size_[1];
+        const uint32_t x = voxel_key / (grid_size_[1] * grid_size_[2]);
+        const uint32_t key = config_.order == PillarOrder::RowMajor ? y * grid_size_[0] + x : morton2d(x, y);
+        max_key = std::max(max_key, key);
+        order_items_[n++] = (static_cast<uint64_t>(key) << 32) | static_cast<uint32_t>(slot);
+    }
+    
+    // LSD radix sort on the key half, 11-bit digits; a 432 x 496 grid has
+    // 18-bit keys in either order, so this is two counting passes
+    constexpr int kDigitBits = 11;
+    constexpr int kBuckets = 1 << kDigitBits;
+    order_tmp_.resize(n);
+    order_count_.resize(kBuckets);
+    for (int shift = 0; shift < 32 && (max_key >> shift) != 0; shift += kDigitBits) {
+        std::fill(order_count_.begin(), order_count_.end(), 0);
+        for (int i = 0; i < n; ++i) {
+            ++order_count_[(order_items_[i] >> (32 + shift)) & (kBuckets - 1)];
+        }
+        int sum = 0;
+        for (int& c : order_count_) {
+            const int count = c;
+            c = sum;
+            sum += count;
+        }
+        for (int i = 0; i < n; ++i) {
+            order_tmp_[order_count_[(order_items_[i] >> (32 + shift)) & (kBuckets - 1)]++] = order_items_[i];
+        }
+        order_items_.swap(order_tmp_);
+    }
+    
+    for (int i = 0; i < n; ++i) {
+        slot_voxel_[static_cast<uint32_t>(order_items_[i])] = i;
+    }
+}
+
 VoxelData Voxelizer::generate(const std::vector<float>& points) {
+    const size_t num_points = points.size() / config_.num_point_features;
+    return generate(std::vector<PointSpan>{{points.data(), num_points}});
+}
+
+VoxelData Voxelizer::generate(const std::vector<PointSpan>& spans) {
     VoxelData result;
+    generate_into(spans, 0, result);
     
-    // Assuming points are in format [x, y, z, intensity, ...]
-    // We'll use the first 4 values per point
-    int num_points = points.size() / 4;
+    if (config_.verbose) {
+        std::cout << "Voxelization complete: " << result.num_voxels << " voxels" << std::endl;
+    }
+    return result;
+}
+
+VoxelData Voxelizer::generate_batch(const std::vector<std::vector<float>>& frames) {
+    if (frames.size() > 256) {
+        throw std::invalid_argument("Voxelizer: at most 256 frames per batch");
+    }
+    VoxelData result;
+    for (size_t b = 0; b < frames.size(); ++b) {
+        const size_t num_points = frames[b].size() / config_.num_point_features;
+        generate_into({{frames[b].data(), num_points}}, static_cast<int>(b), result);
+    }
     
-    // Map from voxel coordinates to list of point indices
-    std::unordered_map<int, std::vector<int>> voxel_map;
+    if (config_.verbose) {
+        std::cout << "Voxelization complete: " << result.num_voxels << " voxels in "
+                  << frames.size() << " frames" << std::endl;
+    }
+    return result;
+}
+
+void Voxelizer::append_voxels(int num_occupied, int num_voxels, int batch_id, VoxelData& result) {
+    const int max_pts = config_.max_num_points;
+    const int F = config_.num_point_features;
+    const int base = result.num_voxels;
+    result.num_voxels = base + num_voxels;
+    result.voxels.resize(static_cast<size_t>(result.num_voxels) * max_pts * F, 0.0f);
+    result.coor_x.resize(result.num_voxels);
+    result.coor_y.resize(result.num_voxels);
+    result.batch_ids.resize(result.num_voxels, static_cast<uint8_t>(batch_id));
+    result.num_points.resize(result.num_voxels);
+    
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        if (slot_voxel_[slot] < 0) {
+            continue;
+        }
+        slot_voxel_[slot] += base;
+        const int voxel_idx = slot_voxel_[slot];
+        const int voxel_key = slot_cell_[slot];
+        
+        // Decode voxel coordinates (z is always 0, see the constructor)
+        result.coor_y[voxel_idx] = static_cast<uint16_t>((voxel_key / grid_size_[2]) % grid_size_[1]);
+        result.coor_x[voxel_idx] = static_cast<uint16_t>(voxel_key / (grid_size_[1] * grid_size_[2]));
+        result.num_points[voxel_idx] = static_cast<uint8_t>(std::min(slot_count_[slot], max_pts));
+    }
+}
+
+void Voxelizer::reset_cells() {
+    // Reset only the cells touched this frame
+    for (int voxel_key : slot_cell_) {
+        cell_slot_[voxel_key] = -1;
+    }
+}
+
+void Voxelizer::generate_into(const std::vector<PointSpan>& spans, int batch_id, VoxelData& result) {
+    if (streaming_) {
+        throw std::logic_error("Voxelizer: generate() called between begin_frame() and end_frame()");
+    }
+    RuntimeDims dims;
+    dims.point_features_ = config_.num_point_features;
+    dims.max_points_ = config_.max_num_points;
+    dispatch_dims(dims, [&](const auto& d) { generate_into_impl(d, spans, batch_id, result); });
+}
+
+template <class Dims>
+void Voxelizer::generate_into_impl(const Dims& dims, const std::vector<PointSpan>& spans,
+                                   int batch_id, VoxelData& result) {
+    // Points are in format [x, y, z, intensity, ...], num_point_features
+    // floats each; the spans are treated as one cloud in order
+    const int F = dims.point_features();
+    int num_points = 0;
+    for (const auto& span : spans) {
+        num_points += static_cast<int>(span.num_points);
+    }
     
-    // Process each point
-    for (int i = 0; i < num_points; ++i) {
-        float x = points[i * 4 + 0];
-        float y = points[i * 4 + 1];
-        float z = points[i * 4 + 2];
-        float intensity = points[i * 4 + 3];
+    // Pass 1: bin every point into its cell and count points per occupied
+    // cell. Cells get a slot on first arrival; no per-voxel index lists.
+    point_cell_.resize(num_points);
+    slot_cell_.clear();
+    slot_count_.clear();
+    
+    for_each_point(spans, F, [&](const float* point, int i) {
+        float x = point[0];
+        float y = point[1];
+        float z = point[2];
         
         auto coords = point_to_grid_coords(x, y, z);
         
         if (coords[0] < 0 || coords[1] < 0 || coords[2] < 0) {
-            continue;  // Skip out-of-range points
+            point_cell_[i] = -1;  // Skip out-of-range points
+            return;
         }
         
         // Create a unique key for this voxel
         int voxel_key = coords[0] * grid_size_[1] * grid_size_[2] + 
                         coords[1] * grid_size_[2] + 
                         coords[2];
+        point_cell_[i] = voxel_key;
         
-        voxel_map[voxel_key].push_back(i);
-    }
+        int& slot = cell_slot_[voxel_key];
+        if (slot < 0) {
+            slot = static_cast<int>(slot_cell_.size());
+            slot_cell_.push_back(voxel_key);
+            slot_count_.push_back(0);
+        }
+        slot_count_[slot]++;
+    });
     
-    // Build voxel data
-    result.voxels.resize(voxel_map.size() * config_.max_num_points * 4, 0.0f);
-    result.coordinates.resize(voxel_map.size() * 4, 0);
-    result.num_points.resize(voxel_map.size(), 0);
-    result.num_voxels = 0;
+    // Voxel budget: decide which occupied cells become voxels
+    const int num_occupied = static_cast<int>(slot_cell_.size());
+    const int num_voxels = select_voxels(num_occupied);
+    order_voxels(num_occupied, num_voxels);
     
-    int voxel_idx = 0;
-    for (const auto& [voxel_key, point_indices] : voxel_map) {
-        if (voxel_idx >= config_.max_voxels) {
-            break;
+    // Build voxel data, appended after any voxels already in `result`
+    const int max_pts = dims.max_points();
+    append_voxels(num_occupied, num_voxels, batch_id, result);
+    
+    // Pass 2: write sampled points straight into their voxel rows. For each
+    // point we know its arrival rank within the voxel and the voxel's final
+    // count, so every sampling mode decides in O(1).
+    slot_seen_.assign(num_occupied, 0);
+    uint32_t rng = config_.sampling_seed * 2654435761u + 0x9E3779B9u;
+    
+    for_each_point(spans, F, [&](const float* point, int i) {
+        const int voxel_key = point_cell_[i];
+        if (voxel_key < 0) {
+            return;
+        }
+        const int slot = cell_slot_[voxel_key];
+        const int voxel_idx = slot_voxel_[slot];
+        if (voxel_idx < 0) {
+            return;
         }
         
-        // Decode voxel coordinates
-        int z_coord = voxel_key % grid_size_[2];
-        int y_coord = (voxel_key / grid_size_[2]) % grid_size_[1];
-        int x_coord = voxel_key / (grid_size_[1] * grid_size_[2]);
+        const int rank = slot_seen_[slot]++;
+        const int count = slot_count_[slot];
+        int dst = -1;
         
-        // Store coordinates (batch_id=0, z, y, x)
-        result.coordinates[voxel_idx * 4 + 0] = 0;  // batch_id
-        result.coordinates[voxel_idx * 4 + 1] = z_coord;
-        result.coordinates[voxel_idx * 4 + 2] = y_coord;
-        result.coordinates[voxel_idx * 4 + 3] = x_coord;
+        if (count <= max_pts) {
+            dst = rank;
+        } else {
+            switch (config_.sampling) {
+                case PointSampling::FirstN:
+                    dst = rank < max_pts ? rank : -1;
+                    break;
+                case PointSampling::Stride: {
+                    // Keep ranks floor(k * count / max_pts), k = 0..max_pts-1
+                    const int k = static_cast<int>((static_cast<int64_t>(rank) * max_pts + count - 1) / count);
+                    dst = (k < max_pts && static_cast<int64_t>(k) * count / max_pts == rank) ? k : -1;
+                    break;
+                }
+                case PointSampling::Reservoir:
+                    if (rank < max_pts) {
+                        dst = rank;
+                    } else {
+                        rng ^= rng << 13;
+                        rng ^= rng >> 17;
+                        rng ^= rng << 5;
+                        const int r = static_cast<int>(rng % static_cast<uint32_t>(rank + 1));
+                        dst = r < max_pts ? r : -1;
+                    }
+                    break;
+            }
+        }
+        if (dst < 0) {
+            return;
+        }
         
-        // Store points in this voxel
-        int num_pts = std::min(static_cast<int>(point_indices.size()), config_.max_num_points);
-        result.num_points[voxel_idx] = num_pts;
+        float* out = result.voxels.data() + (static_cast<size_t>(voxel_idx) * max_pts + dst) * F;
+        std::copy(point, point + F, out);
+    });
+    
+    reset_cells();
+    
+    if (config_.verbose && num_occupied > num_voxels) {
+        std::cout << "Voxelization dropped " << (num_occupied - num_voxels)
+                  << " voxels over max_voxels" << std::endl;
+    }
+}
+
+
+void Voxelizer::begin_frame() {
+    if (config_.sampling == PointSampling::Stride) {
+        throw std::invalid_argument("Voxelizer: streaming does not support PointSampling::Stride");
+    }
+    // An abandoned frame still owns its cells
+    if (streaming_) {
+        reset_cells();
+    }
+    streaming_ = true;
+    slot_cell_.clear();
+    slot_count_.clear();
+    stream_rng_ = config_.sampling_seed * 2654435761u + 0x9E3779B9u;
+}
+
+void Voxelizer::add_points(const float* points, size_t num_points) {
+    if (!streaming_) {
+        throw std::logic_error("Voxelizer::add_points called outside begin_frame() / end_frame()");
+    }
+    RuntimeDims dims;
+    dims.point_features_ = config_.num_point_features;
+    dims.max_points_ = config_.max_num_points;
+    dispatch_dims(dims, [&](const auto& d) { add_points_impl(d, points, num_points); });
+}
+
+template <class Dims>
+void Voxelizer::add_points_impl(const Dims& dims, const float* points, size_t num_points) {
+    const int F = dims.point_features();
+    const int max_pts = dims.max_points();
+    const size_t row_size = static_cast<size_t>(max_pts) * F;
+    // Under FirstArrival the kept cells are known on arrival, so later cells
+    // are only counted and never staged
+    const bool first_arrival = config_.budget == VoxelBudget::FirstArrival;
+    
+    for (size_t i = 0; i < num_points; ++i) {
+        const float* point = points + i * F;
+        auto coords = point_to_grid_coords(point[0], point[1], point[2]);
+        if (coords[0] < 0 || coords[1] < 0 || coords[2] < 0) {
+            continue;
+        }
+        const int voxel_key = coords[0] * grid_size_[1] * grid_size_[2] +
+                              coords[1] * grid_size_[2] +
+                              coords[2];
         
-        for (int p = 0; p < num_pts; ++p) {
-            int point_idx = point_indices[p];
-            result.voxels[voxel_idx * config_.max_num_points * 4 + p * 4 + 0] = points[point_idx * 4 + 0];
-            result.voxels[voxel_idx * config_.max_num_points * 4 + p * 4 + 1] = points[point_idx * 4 + 1];
-            result.voxels[voxel_idx * config_.max_num_points * 4 + p * 4 + 2] = points[point_idx * 4 + 2];
-            result.voxels[voxel_idx * config_.max_num_points * 4 + p * 4 + 3] = points[point_idx * 4 + 3];
+        int& slot = cell_slot_[voxel_key];
+        if (slot < 0) {
+            slot = static_cast<int>(slot_cell_.size());
+            slot_cell_.push_back(voxel_key);
+            slot_count_.push_back(0);
+            if (!first_arrival || slot < config_.max_voxels) {
+                stream_rows_.resize(std::max(stream_rows_.size(), (static_cast<size_t>(slot) + 1) * row_size));
+            }
+        }
+        const int rank = slot_count_[slot]++;
+        if (first_arrival && slot >= config_.max_voxels) {
+            continue;
         }
         
-        voxel_idx++;
+        // Same decisions as pass 2 of generate(); FirstN and Reservoir only
+        // depend on the points seen so far
+        int dst = rank < max_pts ? rank : -1;
+        if (dst < 0 && config_.sampling == PointSampling::Reservoir) {
+            stream_rng_ ^= stream_rng_ << 13;
+            stream_rng_ ^= stream_rng_ >> 17;
+            stream_rng_ ^= stream_rng_ << 5;
+            const int r = static_cast<int>(stream_rng_ % static_cast<uint32_t>(rank + 1));
+            dst = r < max_pts ? r : -1;
+        }
+        if (dst >= 0) {
+            std::copy(point, point + F, stream_rows_.data() + static_cast<size_t>(slot) * row_size + dst * F);
+        }
+    }
+}
+
+VoxelData Voxelizer::end_frame() {
+    if (!streaming_) {
+        throw std::logic_error("Voxelizer::end_frame called without begin_frame()");
     }
+    streaming_ = false;
     
-    result.num_voxels = voxel_idx;
+    const int num_occupied = static_cast<int>(slot_cell_.size());
+    const int num_voxels = select_voxels(num_occupied);
+    order_voxels(num_occupied, num_voxels);
     
-    // Trim to actual size
-    result.voxels.resize(result.num_voxels * config_.max_num_points * 4);
-    result.coordinates.resize(result.num_voxels * 4);
-    result.num_points.resize(result.num_voxels);
+    VoxelData result;
+    append_voxels(num_occupied, num_voxels, 0, result);
     
-    std::cout << "Voxelization complete: " << result.num_voxels << " voxels" << std::endl;
+    // Gather the staged rows; only the valid points are copied, the padding
+    // is already zero
+    const size_t row_size = static_cast<size_t>(config_.max_num_points) * config_.num_point_features;
+    for (int slot = 0; slot < num_occupied; ++slot) {
+        const int voxel_idx = slot_voxel_[slot];
+        if (voxel_idx < 0) {
+            continue;
+        }
+        const float* src = stream_rows_.data() + static_cast<size_t>(slot) * row_size;
+        std::copy(src, src + static_cast<size_t>(result.num_points[voxel_idx]) * config_.num_point_features,
+                  result.voxels.data() + static_cast<size_t>(voxel_idx) * row_size);
+    }
+    reset_cells();
     
+    if (config_.verbose) {
+        if (num_occupied > num_voxels) {
+            std::cout << "Voxelization dropped " << (num_occupied - num_voxels)
+                      << " voxels over max_voxels" << std::endl;
+        }
+        std::cout << "Voxelization complete: " << result.num_voxels << " voxels" << std::endl;
+    }
     return result;
 }
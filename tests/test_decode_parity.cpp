@@ -0,0 +1,175 @@
+// decode + NMS 对 vec_math 内核的一致性测试：同一帧点云（体素化 -> PFN -> CpuRPN）
+// 分别用 vec_math 内核和逐元素 libm（vec_math.cpp 以 VECMATH_LIBM_REFERENCE 编译）
+// 解码 + NMS，比较两边的框。两个版本链接不同的 vec_math，所以分两个可执行文件：
+//   test_decode_parity_libm <点云.bin> <pfn_weight.bin> <pfn_bias.bin> --dump <结果文件>
+//   test_decode_parity      <点云.bin> <pfn_weight.bin> <pfn_bias.bin> --compare <结果文件>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cpu_rpn.h"
+#include "pfn.hpp"
+#include "postprocess.h"
+#include "tool_common.h"
+#include "vec_math.h"
+#include "voxelizer.h"
+
+namespace {
+
+constexpr float kScoreThr = 0.3f;
+constexpr float kNmsThr = 0.01f;
+constexpr int kMaxNum = 100;
+
+// 容差：score 只经过 sigmoid（绝对误差 < 1e-7），尺寸经过 exp（相对误差 < 1e-7）
+constexpr float kScoreTol = 1e-6f;
+constexpr float kSizeRelTol = 1e-6f;
+constexpr float kPosTol = 1e-4f;
+
+struct Result {
+    std::vector<Box3D> decoded;
+    std::vector<Box3D> kept;
+};
+
+Result run(const std::string& cloud, const std::string& weight, const std::string& bias) {
+    VoxelConfig voxel_cfg;
+    voxel_cfg.verbose = false;
+    Voxelizer voxelizer(voxel_cfg);
+    VoxelData voxel_data = voxelizer.generate(tools::load_bin(cloud));
+
+    PFN_CPU pfn;
+    pfn.pfn_weights = tools::load_bin(weight);
+    pfn.pfn_bias = tools::load_bin(bias);
+    pfn.voxel = voxel_cfg;
+    SparsePillars pillars;
+    pfn.run_sparse(make_voxel_info(voxel_data, voxel_cfg), pillars);
+
+    // score_bias 取 -1：被占用的 cell 大多过阈值，decode / NMS 都有足够多的框
+    CpuRPNConfig rpn_cfg;
+    rpn_cfg.max_batch = 1;
+    rpn_cfg.score_bias = -1.0f;
+    rpn_cfg.dir_channels = 12;
+    CpuRPN rpn(rpn_cfg);
+    std::vector<float> box_map(static_cast<size_t>(rpn_cfg.box_channels) * rpn_cfg.grid_h * rpn_cfg.grid_w);
+    std::vector<float> score_map(static_cast<size_t>(rpn_cfg.score_channels) * rpn_cfg.grid_h * rpn_cfg.grid_w);
+    rpn.run_sparse(pillars, box_map.data(), score_map.data());
+
+    DecodeConfig decode_cfg;
+    decode_cfg.verbose = false;
+    AnchorDecoder decoder(decode_cfg);
+    Result result;
+    result.decoded = decoder.decode(box_map.data(), score_map.data(), kScoreThr, rpn.dir_map());
+    result.kept = nms_bev_rotated(result.decoded, kNmsThr, kMaxNum, false);
+    return result;
+}
+
+void write_boxes(std::ostream& out, const char* name, const std::vector<Box3D>& boxes) {
+    out << name << " " << boxes.size() << "\n";
+    char line[256];
+    for (const auto& b : boxes) {
+        std::snprintf(line, sizeof(line), "%d %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n",
+                      b.label, b.x, b.y, b.z, b.w, b.l, b.h, b.rot, b.score);
+        out << line;
+    }
+}
+
+std::vector<Box3D> read_boxes(std::istream& in, const std::string& name) {
+    std::string tag;
+    size_t n = 0;
+    if (!(in >> tag >> n) || tag != name) {
+        throw std::runtime_error("结果文件格式错误: 缺少 " + name);
+    }
+    std::vector<Box3D> boxes(n);
+    for (auto& b : boxes) {
+        in >> b.label >> b.x >> b.y >> b.z >> b.w >> b.l >> b.h >> b.rot >> b.score;
+    }
+    if (!in) {
+        throw std::runtime_error("结果文件格式错误: " + name + " 不完整");
+    }
+    return boxes;
+}
+
+// x / y / rot 不经过 vec_math，两边逐位相同，用作配对的键；
+// 按键排序后逐个比较，score 相近的框在两边排序不同也不影响
+auto box_key(const Box3D& b) { return std::make_tuple(b.label, b.x, b.y, b.rot); }
+
+bool close_rel(float a, float b, float tol) { return std::abs(a - b) <= tol * std::max(std::abs(a), std::abs(b)); }
+
+// 返回不一致的框数；score 贴着阈值（差值在容差内）的框允许只出现在一边
+int compare_boxes(const char* name, std::vector<Box3D> ref, std::vector<Box3D> got, float score_edge) {
+    auto by_key = [](const Box3D& a, const Box3D& b) { return box_key(a) < box_key(b); };
+    std::sort(ref.begin(), ref.end(), by_key);
+    std::sort(got.begin(), got.end(), by_key);
+
+    int mismatches = 0;
+    float max_score = 0, max_size = 0, max_z = 0;
+    size_t i = 0, j = 0;
+    while (i < ref.size() || j < got.size()) {
+        if (j == got.size() || (i < ref.size() && by_key(ref[i], got[j]))) {
+            if (std::abs(ref[i].score - score_edge) > kScoreTol) ++mismatches;
+            ++i;
+        } else if (i == ref.size() || by_key(got[j], ref[i])) {
+            if (std::abs(got[j].score - score_edge) > kScoreTol) ++mismatches;
+            ++j;
+        } else {
+            const Box3D& a = ref[i++];
+            const Box3D& b = got[j++];
+            max_score = std::max(max_score, std::abs(a.score - b.score));
+            max_z = std::max(max_z, std::abs(a.z - b.z));
+            for (auto [u, v] : {std::make_pair(a.w, b.w), std::make_pair(a.l, b.l), std::make_pair(a.h, b.h)}) {
+                max_size = std::max(max_size, std::abs(u - v) / std::max(std::abs(u), std::abs(v)));
+            }
+            if (std::abs(a.score - b.score) > kScoreTol || std::abs(a.z - b.z) > kPosTol ||
+                !close_rel(a.w, b.w, kSizeRelTol) || !close_rel(a.l, b.l, kSizeRelTol) ||
+                !close_rel(a.h, b.h, kSizeRelTol)) {
+                ++mismatches;
+            }
+        }
+    }
+    std::cout << name << ": libm " << ref.size() << " 个框, " << vecmath::isa_name() << " " << got.size()
+              << " 个框, 不一致 " << mismatches << " (最大误差 score " << max_score << ", 尺寸相对 "
+              << max_size << ", z " << max_z << ")\n";
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 6 || (std::string(argv[4]) != "--dump" && std::string(argv[4]) != "--compare")) {
+        std::cerr << "用法: " << argv[0] << " <点云.bin> <pfn_weight.bin> <pfn_bias.bin> --dump|--compare <结果文件>\n";
+        return 2;
+    }
+    try {
+        Result result = run(argv[1], argv[2], argv[3]);
+        const std::string mode = argv[4];
+        const std::string path = argv[5];
+
+        if (mode == "--dump") {
+            std::ofstream out(path);
+            write_boxes(out, "decoded", result.decoded);
+            write_boxes(out, "kept", result.kept);
+            if (!out) throw std::runtime_error("无法写入: " + path);
+            std::cout << vecmath::isa_name() << ": decode " << result.decoded.size() << " 个框, NMS 后 "
+                      << result.kept.size() << " 个框\n";
+            return result.kept.empty() ? 1 : 0;
+        }
+
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("无法打开: " + path);
+        auto ref_decoded = read_boxes(in, "decoded");
+        auto ref_kept = read_boxes(in, "kept");
+        int mismatches = compare_boxes("decode", ref_decoded, result.decoded, kScoreThr);
+        // NMS 输出必须一一对应，不放宽阈值边缘
+        mismatches += compare_boxes("nms", ref_kept, result.kept, -1.0f);
+        return mismatches == 0 && !result.kept.empty() ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << "\n";
+        return 1;
+    }
+}
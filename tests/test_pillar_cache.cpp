@@ -0,0 +1,145 @@
+// 时序 pillar 缓存的增量路径：两个传感器的帧交替送进同一个 PFN_CPU，检查
+//   - RPNBackend 稠密回退（增量 scatter）和 PFN_CPU::run_incremental 写出的稠密输入
+//     与不带缓存、完整 scatter 的结果逐位一致；
+//   - 基准帧匹配时确实走了增量路径，且只重写了变化的 cell；
+//   - 缓存按传感器分开，别的传感器的帧不会冲掉自己的缓存。
+// 用法: test_pillar_cache <点云.bin> <pfn_weight.bin> <pfn_bias.bin>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "pfn.hpp"
+#include "rpn_backend.h"
+#include "tool_common.h"
+#include "voxelizer.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "FAIL: " << what << "\n";
+        ++failures;
+    }
+}
+
+// 只走默认 run_sparse（稠密回退）的后端：把收到的稠密输入和期望值逐位比较
+class ProbeBackend : public RPNBackend {
+public:
+    const float* expected = nullptr;
+    size_t size = 0;
+    bool matched = false;
+
+    void run(const float* rpn_input_map, float*, float*, int) override {
+        matched = std::memcmp(rpn_input_map, expected, size * sizeof(float)) == 0;
+    }
+};
+
+// 四帧点云：A 为原始帧，A2 把 x > 40 m 的点横向移 0.3 m，A3 再去掉 x < 10 m 的点，B 左右镜像
+std::vector<std::vector<float>> make_frames(const std::vector<float>& a) {
+    std::vector<float> a2 = a, a3, b = a;
+    for (size_t i = 0; i < a2.size(); i += 4) {
+        if (a2[i] > 40.0f) a2[i + 1] += 0.3f;
+    }
+    for (size_t i = 0; i < a2.size(); i += 4) {
+        if (a2[i] >= 10.0f) a3.insert(a3.end(), a2.begin() + i, a2.begin() + i + 4);
+    }
+    for (size_t i = 0; i < b.size(); i += 4) b[i + 1] = -b[i + 1];
+    return {a, a2, a3, b};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        std::cerr << "用法: " << argv[0] << " <点云.bin> <pfn_weight.bin> <pfn_bias.bin>\n";
+        return 2;
+    }
+    try {
+        const auto frames = make_frames(tools::load_bin(argv[1]));
+        enum { A, A2, A3, B };
+
+        VoxelConfig voxel_cfg;
+        voxel_cfg.verbose = false;
+        Voxelizer voxelizer(voxel_cfg);
+
+        PFN_CPU ref;  // 不带缓存，每帧完整 scatter 作为期望值
+        ref.pfn_weights = tools::load_bin(argv[2]);
+        ref.pfn_bias = tools::load_bin(argv[3]);
+        ref.voxel = voxel_cfg;
+        PFN_CPU cached = ref;
+        cached.enable_cache();
+        PFN_CPU incremental = ref;
+        incremental.enable_cache();
+
+        const size_t map_size = static_cast<size_t>(ref.pfn_bias.size()) * ref.grid_h * ref.grid_w;
+        std::vector<float> expected(map_size), inc_map(map_size), patched(map_size);
+        ProbeBackend backend;
+        backend.expected = expected.data();
+        backend.size = map_size;
+
+        // (传感器, 帧, 后端是否应走增量路径, 本帧是否应全部命中缓存)
+        struct Step { int sensor, frame; bool delta, all_hit; };
+        const Step steps[] = {
+            {0, A, false, false},
+            {0, A, true, true},
+            {0, A2, true, false},
+            {1, B, false, false},
+            {1, B, true, true},
+            {0, A2, false, true},   // 中间处理过传感器 1，传感器 0 的缓存仍在
+            {0, A3, true, false},
+        };
+
+        SparsePillars pillars, ref_pillars;
+        uint64_t backend_frame = 0;
+        for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+            const Step& s = steps[i];
+            const std::string tag = "第 " + std::to_string(i) + " 步";
+            VoxelData voxel_data = voxelizer.generate(frames[s.frame]);
+            const VoxelInfo info = make_voxel_info(voxel_data, voxel_cfg);
+
+            patched = expected;  // 上一帧的完整结果
+            ref.run_sparse(info, ref_pillars);
+            scatter_sparse_to_dense(ref_pillars, expected.data());
+
+            cached.set_cache_key(s.sensor);
+            cached.run_sparse(info, pillars);
+            const bool delta = pillars.base_frame != 0 && pillars.base_frame == backend_frame;
+            backend_frame = pillars.frame;
+            backend.run_sparse(pillars, nullptr, nullptr);
+            const auto& stats = cached.cache_stats();
+            std::cout << tag << ": 传感器 " << s.sensor << ", " << stats.last_pillars << " 个 pillar, 重算 "
+                      << stats.last_changed << ", 消失 " << stats.last_removed
+                      << (delta ? ", 增量 scatter" : ", 完整 scatter") << "\n";
+
+            check(backend.matched, tag + ": 后端稠密输入与完整 scatter 不一致");
+            check(delta == s.delta, tag + ": 后端增量路径与预期不符");
+            check((stats.last_changed == 0) == s.all_hit, tag + ": 缓存命中与预期不符");
+            if (s.delta) {
+                // 单独验证增量 scatter：在上一帧的稠密输入上只写差异，结果应与完整 scatter 相同
+                scatter_pillar_delta(pillars, patched.data());
+                check(std::memcmp(patched.data(), expected.data(), map_size * sizeof(float)) == 0,
+                      tag + ": scatter_pillar_delta 结果与完整 scatter 不一致");
+                check(stats.last_changed + stats.last_removed < stats.last_pillars, tag + ": 增量没有省下写入");
+            }
+
+            incremental.set_cache_key(s.sensor);
+            incremental.run_incremental(info, inc_map.data());
+            check(std::memcmp(inc_map.data(), expected.data(), map_size * sizeof(float)) == 0,
+                  tag + ": run_incremental 结果与完整 scatter 不一致");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << "\n";
+        return 1;
+    }
+    if (failures) {
+        std::cout << failures << " 项检查失败\n";
+        return 1;
+    }
+    std::cout << "全部通过\n";
+    return 0;
+}
@@ -0,0 +1,354 @@
+// 延迟 / 精度自动调参：用 CpuRPN 替身回放一组帧，扫描流水线参数的所有组合，
+// 测每帧各阶段耗时和相对参考配置的检测一致性，把 Pareto 前沿（p95 延迟越低越好、F1 越高越好）
+// 写成 JSON，每个前沿点带可以直接使用的配置和 pointpillars_server 命令行参数
+//
+// 用法: autotune [--data-dir <dir>] [--frames N] [--iters N] [-o out.json]
+//                [--pfn-weight p] [--pfn-bias p] [--bundle path] [--rpn-latency-ms X]
+//                [--rpn-score-bias X] [--match-dist m]
+//                [--max-voxels a,b,..] [--max-points a,b,..] [--score-thr a,b,..]
+//                [--nms-thr a,b,..] [--nms-threads a,b,..] [--nms-pre a,b,..]
+//
+// 参考配置为 PipelineConfig 默认值（有 --bundle 时体素 / decode 配置取自模型包）。
+// 一致性：每帧的参考框按 score 降序，依次匹配同类别、未被占用、BEV 中心距离最近且 <= match-dist
+// 的候选框，所有帧累加后算 precision / recall / F1。
+// CpuRPN 的输出没有检测意义，这里衡量的是参数对结果的扰动；换成真实后端时流程不变。
+// CpuRPN 默认的 score bias 让几乎所有 cell 都低于阈值，这里默认调高，使参考配置有足够多的框
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cpu_rpn.h"
+#include "model_bundle.h"
+#include "pipeline.h"
+#include "tool_common.h"
+
+namespace {
+
+struct Knobs {
+    int max_voxels = 0;
+    int max_points = 0;
+    float score_thr = 0.0f;
+    float nms_thr = 0.0f;
+    int nms_threads = 1;
+    int nms_pre = 0;
+};
+
+struct Result {
+    Knobs knobs;
+    StageTimings mean;          // 每帧平均
+    double p50_ms = 0;
+    double p95_ms = 0;
+    double precision = 1.0;
+    double recall = 1.0;
+    double f1 = 1.0;
+};
+
+// "a,b,c" -> {a, b, c}
+template <class T>
+std::vector<T> parse_list(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        values.push_back(static_cast<T>(std::stod(item)));
+    }
+    if (values.empty()) {
+        throw std::invalid_argument("参数列表为空: " + text);
+    }
+    return values;
+}
+
+// 参考框逐个贪心匹配候选框，返回匹配数
+size_t count_matches(const std::vector<Box3D>& ref, const std::vector<Box3D>& cand, float match_dist) {
+    std::vector<bool> used(cand.size(), false);
+    const float max_d2 = match_dist * match_dist;
+    size_t matched = 0;
+    for (const auto& r : ref) {
+        int best = -1;
+        float best_d2 = max_d2;
+        for (size_t i = 0; i < cand.size(); ++i) {
+            if (used[i] || cand[i].label != r.label) continue;
+            const float dx = cand[i].x - r.x;
+            const float dy = cand[i].y - r.y;
+            const float d2 = dx * dx + dy * dy;
+            if (d2 <= best_d2) {
+                best = static_cast<int>(i);
+                best_d2 = d2;
+            }
+        }
+        if (best >= 0) {
+            used[best] = true;
+            ++matched;
+        }
+    }
+    return matched;
+}
+
+PipelineConfig apply_knobs(PipelineConfig config, const Knobs& k) {
+    config.voxel.max_voxels = k.max_voxels;
+    config.voxel.max_num_points = k.max_points;
+    config.score_thr = k.score_thr;
+    config.nms_thr = k.nms_thr;
+    config.nms_threads = k.nms_threads;
+    config.nms_pre = k.nms_pre;
+    config.max_batch = 1;
+    config.verbose = false;
+    return config;
+}
+
+// 跑一组参数：先预热一帧，再把所有帧回放 iters 遍；boxes 为第一遍每帧的结果
+Result evaluate(const PipelineConfig& base, const Knobs& knobs, const PFN_CPU& pfn,
+                const std::vector<std::vector<float>>& frames, int iters, CpuRPNConfig rpn_config,
+                std::vector<std::vector<Box3D>>& boxes) {
+    rpn_config.max_batch = 1;
+    Pipeline pipeline(apply_knobs(base, knobs), pfn, std::make_unique<CpuRPN>(rpn_config));
+    pipeline.process(frames[0]);
+
+    Result result;
+    result.knobs = knobs;
+    std::vector<double> totals;
+    boxes.assign(frames.size(), {});
+    for (int it = 0; it < iters; ++it) {
+        for (size_t f = 0; f < frames.size(); ++f) {
+            StageTimings t;
+            auto out = pipeline.process(frames[f], &t);
+            if (it == 0) boxes[f] = std::move(out);
+            result.mean.prefilter_ms += t.prefilter_ms;
+            result.mean.voxel_ms += t.voxel_ms;
+            result.mean.pfn_ms += t.pfn_ms;
+            result.mean.rpn_ms += t.rpn_ms;
+            result.mean.decode_ms += t.decode_ms;
+            result.mean.nms_ms += t.nms_ms;
+            result.mean.total_ms += t.total_ms;
+            totals.push_back(t.total_ms);
+        }
+    }
+    const double n = static_cast<double>(totals.size());
+    result.mean.prefilter_ms /= n;
+    result.mean.voxel_ms /= n;
+    result.mean.pfn_ms /= n;
+    result.mean.rpn_ms /= n;
+    result.mean.decode_ms /= n;
+    result.mean.nms_ms /= n;
+    result.mean.total_ms /= n;
+    result.p50_ms = tools::percentile(totals, 50.0);
+    result.p95_ms = tools::percentile(totals, 95.0);
+    return result;
+}
+
+void score_agreement(Result& result, const std::vector<std::vector<Box3D>>& ref,
+                     const std::vector<std::vector<Box3D>>& cand, float match_dist) {
+    size_t matched = 0, num_ref = 0, num_cand = 0;
+    for (size_t f = 0; f < ref.size(); ++f) {
+        matched += count_matches(ref[f], cand[f], match_dist);
+        num_ref += ref[f].size();
+        num_cand += cand[f].size();
+    }
+    // 两边都没有框算完全一致
+    result.precision = num_cand ? static_cast<double>(matched) / num_cand : (num_ref ? 0.0 : 1.0);
+    result.recall = num_ref ? static_cast<double>(matched) / num_ref : (num_cand ? 0.0 : 1.0);
+    const double denom = result.precision + result.recall;
+    result.f1 = denom > 0 ? 2.0 * result.precision * result.recall / denom : 0.0;
+}
+
+// p95 升序扫描，只保留 F1 严格高于之前所有点的结果
+std::vector<Result> pareto_front(std::vector<Result> results) {
+    std::sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+        if (a.p95_ms != b.p95_ms) return a.p95_ms < b.p95_ms;
+        return a.f1 > b.f1;
+    });
+    std::vector<Result> front;
+    for (const auto& r : results) {
+        if (front.empty() || r.f1 > front.back().f1) front.push_back(r);
+    }
+    return front;
+}
+
+std::string server_flags(const Knobs& k) {
+    std::ostringstream os;
+    os << "--max-voxels " << k.max_voxels << " --max-points " << k.max_points
+       << " --score-thr " << k.score_thr << " --nms-thr " << k.nms_thr
+       << " --nms-threads " << k.nms_threads << " --nms-pre " << k.nms_pre;
+    return os.str();
+}
+
+void write_result_json(std::ostream& os, const Result& r, const char* indent) {
+    const Knobs& k = r.knobs;
+    os << indent << "{\n"
+       << indent << "  \"config\": {\"voxel\": {\"max_voxels\": " << k.max_voxels
+       << ", \"max_num_points\": " << k.max_points << "}, \"score_thr\": " << k.score_thr
+       << ", \"nms_thr\": " << k.nms_thr << ", \"nms_threads\": " << k.nms_threads
+       << ", \"nms_pre\": " << k.nms_pre << "},\n"
+       << indent << "  \"server_flags\": \"" << server_flags(k) << "\",\n"
+       << indent << "  \"latency_ms\": {\"p50\": " << r.p50_ms << ", \"p95\": " << r.p95_ms
+       << ", \"mean\": " << r.mean.total_ms << ", \"prefilter\": " << r.mean.prefilter_ms
+       << ", \"voxel\": " << r.mean.voxel_ms << ", \"pfn\": " << r.mean.pfn_ms
+       << ", \"rpn\": " << r.mean.rpn_ms << ", \"decode\": " << r.mean.decode_ms
+       << ", \"nms\": " << r.mean.nms_ms << "},\n"
+       << indent << "  \"agreement\": {\"precision\": " << r.precision << ", \"recall\": " << r.recall
+       << ", \"f1\": " << r.f1 << "}\n"
+       << indent << "}";
+}
+
+void print_row(const Result& r) {
+    const Knobs& k = r.knobs;
+    std::cout << std::setw(7) << k.max_voxels << std::setw(5) << k.max_points
+              << std::setw(7) << k.score_thr << std::setw(7) << k.nms_thr
+              << std::setw(4) << k.nms_threads << std::setw(6) << k.nms_pre
+              << std::setw(9) << r.mean.total_ms << std::setw(9) << r.p95_ms
+              << std::setw(8) << r.f1 << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string data_dir;
+    std::string out_path = "autotune.json";
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    std::string bundle_path;
+    std::string default_frame = "test/kitti_000008.bin";
+    int num_frames = 8;
+    int iters = 2;
+    double rpn_latency_ms = 0.0;
+    float rpn_score_bias = -1.0f;
+    float match_dist = 0.5f;
+    std::string max_voxels_list = "40000,16000,8000";
+    std::string max_points_list = "32,16";
+    std::string score_thr_list = "0.3,0.4,0.5";
+    std::string nms_thr_list = "0.01,0.1";
+    std::string nms_threads_list = "1";
+    std::string nms_pre_list = "0,1000,100";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data-dir" && i + 1 < argc) data_dir = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc) num_frames = std::stoi(argv[++i]);
+        else if (arg == "--iters" && i + 1 < argc) iters = std::stoi(argv[++i]);
+        else if (arg == "-o" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else if (arg == "--bundle" && i + 1 < argc) bundle_path = argv[++i];
+        else if (arg == "--rpn-latency-ms" && i + 1 < argc) rpn_latency_ms = std::stod(argv[++i]);
+        else if (arg == "--rpn-score-bias" && i + 1 < argc) rpn_score_bias = std::stof(argv[++i]);
+        else if (arg == "--match-dist" && i + 1 < argc) match_dist = std::stof(argv[++i]);
+        else if (arg == "--max-voxels" && i + 1 < argc) max_voxels_list = argv[++i];
+        else if (arg == "--max-points" && i + 1 < argc) max_points_list = argv[++i];
+        else if (arg == "--score-thr" && i + 1 < argc) score_thr_list = argv[++i];
+        else if (arg == "--nms-thr" && i + 1 < argc) nms_thr_list = argv[++i];
+        else if (arg == "--nms-threads" && i + 1 < argc) nms_threads_list = argv[++i];
+        else if (arg == "--nms-pre" && i + 1 < argc) nms_pre_list = argv[++i];
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (iters < 1) {
+        std::cerr << "--iters 必须 >= 1" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<std::vector<float>> frames;
+        if (!data_dir.empty()) {
+            for (const auto& f : tools::list_bin_files(data_dir)) {
+                if (static_cast<int>(frames.size()) >= num_frames) break;
+                frames.push_back(tools::load_bin(f));
+            }
+        }
+        if (frames.empty()) {
+            frames.assign(num_frames, tools::load_bin(default_frame));
+        }
+
+        PFN_CPU pfn;
+        PipelineConfig base_config;
+        if (!bundle_path.empty()) {
+            ModelBundle bundle(bundle_path);
+            base_config.voxel = bundle.voxel_config(base_config.voxel);
+            base_config.decode = bundle.decode_config(base_config.decode);
+            pfn.use_packed_weights(bundle.pfn_weights());
+        } else {
+            pfn.pfn_weights = tools::load_bin(pfn_weight);
+            pfn.pfn_bias = tools::load_bin(pfn_bias);
+        }
+
+        CpuRPNConfig rpn_config;
+        rpn_config.simulated_latency_ms = static_cast<float>(rpn_latency_ms);
+        rpn_config.score_bias = rpn_score_bias;
+
+        std::vector<Knobs> grid;
+        for (int mv : parse_list<int>(max_voxels_list))
+            for (int mp : parse_list<int>(max_points_list))
+                for (float st : parse_list<float>(score_thr_list))
+                    for (float nt : parse_list<float>(nms_thr_list))
+                        for (int th : parse_list<int>(nms_threads_list))
+                            for (int pre : parse_list<int>(nms_pre_list))
+                                grid.push_back({mv, mp, st, nt, th, pre});
+
+        Knobs ref_knobs;
+        ref_knobs.max_voxels = base_config.voxel.max_voxels;
+        ref_knobs.max_points = base_config.voxel.max_num_points;
+        ref_knobs.score_thr = base_config.score_thr;
+        ref_knobs.nms_thr = base_config.nms_thr;
+        ref_knobs.nms_threads = base_config.nms_threads;
+        ref_knobs.nms_pre = base_config.nms_pre;
+
+        std::cout << "帧数: " << frames.size() << ", 组合数: " << grid.size() << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << " voxels  pts  score    nms thr   pre  mean_ms   p95_ms      F1\n";
+
+        std::vector<std::vector<Box3D>> ref_boxes, boxes;
+        Result reference = evaluate(base_config, ref_knobs, pfn, frames, iters, rpn_config, ref_boxes);
+        std::cout << "参考配置:\n";
+        print_row(reference);
+
+        std::vector<Result> results;
+        results.reserve(grid.size());
+        for (const auto& knobs : grid) {
+            Result r = evaluate(base_config, knobs, pfn, frames, iters, rpn_config, boxes);
+            score_agreement(r, ref_boxes, boxes, match_dist);
+            print_row(r);
+            results.push_back(r);
+        }
+
+        const auto front = pareto_front(results);
+        std::cout << "Pareto 前沿 (" << front.size() << " 个):\n";
+        for (const auto& r : front) print_row(r);
+
+        size_t num_ref_boxes = 0;
+        for (const auto& b : ref_boxes) num_ref_boxes += b.size();
+
+        std::ofstream out(out_path);
+        if (!out) {
+            throw std::runtime_error("无法写入: " + out_path);
+        }
+        out << std::setprecision(6);
+        out << "{\n"
+            << "  \"frames\": " << frames.size() << ",\n"
+            << "  \"iters\": " << iters << ",\n"
+            << "  \"match_dist\": " << match_dist << ",\n"
+            << "  \"rpn_score_bias\": " << rpn_score_bias << ",\n"
+            << "  \"evaluated\": " << results.size() << ",\n"
+            << "  \"reference_boxes\": " << num_ref_boxes << ",\n"
+            << "  \"reference\":\n";
+        write_result_json(out, reference, "  ");
+        out << ",\n  \"pareto_front\": [\n";
+        for (size_t i = 0; i < front.size(); ++i) {
+            write_result_json(out, front[i], "    ");
+            out << (i + 1 < front.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        std::cout << "已写入 " << out_path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+// batch-N 基准：同一组帧分别以 batch = 1, 2, 4, ... 送入 Pipeline，
+// 后端使用 CpuRPN 替身，对比每帧耗时和吞吐
+//
+// 用法: bench_batch [--data-dir <dir>] [--frames N] [--max-batch N]
+//                   [--iters N] [--rpn-latency-ms X] [--pfn-weight p] [--pfn-bias p]
+//                   [--dir-head]   (CpuRPN 额外输出方向分类 head，decode 走方向解码)
+//                   [--nms-threads N]  (1 = 串行 NMS，0 = 硬件线程数)
+//                   [--dynamic-voxel]  (动态体素化，点直接进 PFN)
+//                   [--pfn-bn prefix]  (加载 <prefix>_{gamma,beta,mean,var}.bin 折叠进 PFN)
+//                   [--bundle path]    (从模型包加载 PFN 权重和体素 / decode 配置)
+//                   [--roi x,y;x,y;...]  (BEV 感兴趣区域多边形，可重复)
+//                   [--center-head]    (CpuRPN 输出 center head 的 heatmap + 回归，decode 走峰值 + top-K，无 NMS)
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpu_rpn.h"
+#include "model_bundle.h"
+#include "pillar_config.h"
+#include "pipeline.h"
+#include "tool_common.h"
+
+int main(int argc, char** argv) {
+    std::string data_dir;
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    std::string pfn_bn;
+    std::string bundle_path;
+    std::string default_frame = "test/kitti_000008.bin";
+    int num_frames = 16;
+    int max_batch = 8;
+    int iters = 3;
+    double rpn_latency_ms = 0.0;
+    bool dir_head = false;
+    int nms_threads = 1;
+    bool dynamic_voxel = false;
+    bool center_head = false;
+    std::vector<RoiMask::Polygon> roi_polygons;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data-dir" && i + 1 < argc) data_dir = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc) num_frames = std::stoi(argv[++i]);
+        else if (arg == "--max-batch" && i + 1 < argc) max_batch = std::stoi(argv[++i]);
+        else if (arg == "--iters" && i + 1 < argc) iters = std::stoi(argv[++i]);
+        else if (arg == "--rpn-latency-ms" && i + 1 < argc) rpn_latency_ms = std::stod(argv[++i]);
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else if (arg == "--pfn-bn" && i + 1 < argc) pfn_bn = argv[++i];
+        else if (arg == "--bundle" && i + 1 < argc) bundle_path = argv[++i];
+        else if (arg == "--dir-head") dir_head = true;
+        else if (arg == "--nms-threads" && i + 1 < argc) nms_threads = std::stoi(argv[++i]);
+        else if (arg == "--dynamic-voxel") dynamic_voxel = true;
+        else if (arg == "--center-head") center_head = true;
+        else if (arg == "--roi" && i + 1 < argc) roi_polygons.push_back(RoiMask::parse_polygon(argv[++i]));
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    try {
+        // 加载帧：目录下的 .bin，或重复使用默认测试帧
+        std::vector<std::vector<float>> frames;
+        if (!data_dir.empty()) {
+            for (const auto& f : tools::list_bin_files(data_dir)) {
+                if (static_cast<int>(frames.size()) >= num_frames) break;
+                frames.push_back(tools::load_bin(f));
+            }
+        }
+        if (frames.empty()) {
+            auto frame = tools::load_bin(default_frame);
+            frames.assign(num_frames, frame);
+        }
+        std::cout << "帧数: " << frames.size() << std::endl;
+        
+        PFN_CPU pfn;
+        PipelineConfig base_config;
+        if (!bundle_path.empty()) {
+            ModelBundle bundle(bundle_path);
+            base_config.voxel = bundle.voxel_config(base_config.voxel);
+            base_config.decode = bundle.decode_config(base_config.decode);
+            pfn.use_packed_weights(bundle.pfn_weights());
+        } else {
+            pfn.pfn_weights = tools::load_bin(pfn_weight);
+            pfn.pfn_bias = tools::load_bin(pfn_bias);
+            if (!pfn_bn.empty()) {
+                pfn.fold_batchnorm(tools::load_bin(pfn_bn + "_gamma.bin"), tools::load_bin(pfn_bn + "_beta.bin"),
+                                   tools::load_bin(pfn_bn + "_mean.bin"), tools::load_bin(pfn_bn + "_var.bin"));
+            }
+        }
+        
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "batch  ms/frame   frames/s   voxel    pfn      rpn      decode+nms (ms/frame)\n";
+        
+        for (int batch = 1; batch <= max_batch; batch *= 2) {
+            PipelineConfig config = base_config;
+            config.max_batch = batch;
+            config.nms_threads = nms_threads;
+            config.dynamic_voxelization = dynamic_voxel;
+            config.roi_polygons = roi_polygons;
+            CpuRPNConfig rpn_config;
+            rpn_config.max_batch = batch;
+            rpn_config.simulated_latency_ms = rpn_latency_ms;
+            rpn_config.dir_channels = dir_head ? KittiPillars::dir_channels : 0;
+            if (center_head) {
+                config.head = HeadType::Center;
+                config.center.grid_x = config.decode.grid_x;
+                config.center.grid_y = config.decode.grid_y;
+                config.center.voxel_size_x = config.decode.voxel_size_x;
+                config.center.voxel_size_y = config.decode.voxel_size_y;
+                config.center.x_min = config.decode.x_min;
+                config.center.y_min = config.decode.y_min;
+                rpn_config.box_channels = config.center.code_size;
+                rpn_config.score_channels = config.center.num_classes;
+                rpn_config.dir_channels = 0;
+            }
+            Pipeline pipeline(config, pfn, std::make_unique<CpuRPN>(rpn_config));
+            
+            StageTimings sum;
+            size_t processed = 0;
+            for (int it = 0; it < iters; ++it) {
+                for (size_t start = 0; start < frames.size(); start += batch) {
+                    size_t end = std::min(frames.size(), start + batch);
+                    std::vector<std::vector<float>> chunk(frames.begin() + start, frames.begin() + end);
+                    StageTimings t;
+                    pipeline.process_batch(chunk, &t);
+                    sum.voxel_ms += t.voxel_ms + t.prefilter_ms;
+                    sum.pfn_ms += t.pfn_ms;
+                    sum.rpn_ms += t.rpn_ms;
+                    sum.decode_ms += t.decode_ms + t.nms_ms;
+                    sum.total_ms += t.total_ms;
+                    processed += chunk.size();
+                }
+            }
+            
+            const double n = static_cast<double>(processed);
+            std::cout << std::setw(5) << batch
+                      << std::setw(11) << sum.total_ms / n
+                      << std::setw(11) << 1000.0 * n / sum.total_ms
+                      << std::setw(9) << sum.voxel_ms / n
+                      << std::setw(9) << sum.pfn_ms / n
+                      << std::setw(9) << sum.rpn_ms / n
+                      << std::setw(9) << sum.decode_ms / n << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
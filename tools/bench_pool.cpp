@@ -0,0 +1,133 @@
+// 引擎池基准：S 个模拟传感器并发提交帧，N 个 Pipeline 实例（CpuRPN 替身）处理，
+// 输出每个实例的吞吐/延迟/利用率，用于评估一台主机能带几路激光雷达
+//
+// 用法: bench_pool [--sensors S] [--instances N] [--frames F] [--cpus-per-instance K]
+//                  [--numa] [--rpn-latency-ms X] [--frame <bin>] [--pfn-weight p] [--pfn-bias p]
+//                  [--rate-hz R] [--deadline-ms D] [--no-degrade]
+//
+// --rate-hz 给每个传感器按固定帧率提交（默认 0 = 尽快提交），配合 --deadline-ms
+// 观察过载时的降级/丢帧/超时比例
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_rpn.h"
+#include "engine_pool.h"
+#include "tool_common.h"
+
+int main(int argc, char** argv) {
+    std::string frame_path = "test/kitti_000008.bin";
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    int num_sensors = 4;
+    int num_instances = 2;
+    int frames_per_sensor = 20;
+    int cpus_per_instance = 0;
+    bool numa = false;
+    double rpn_latency_ms = 0.0;
+    double rate_hz = 0.0;
+    double deadline_ms = 0.0;
+    bool degrade = true;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sensors" && i + 1 < argc) num_sensors = std::stoi(argv[++i]);
+        else if (arg == "--instances" && i + 1 < argc) num_instances = std::stoi(argv[++i]);
+        else if (arg == "--frames" && i + 1 < argc) frames_per_sensor = std::stoi(argv[++i]);
+        else if (arg == "--cpus-per-instance" && i + 1 < argc) cpus_per_instance = std::stoi(argv[++i]);
+        else if (arg == "--numa") numa = true;
+        else if (arg == "--rpn-latency-ms" && i + 1 < argc) rpn_latency_ms = std::stod(argv[++i]);
+        else if (arg == "--frame" && i + 1 < argc) frame_path = argv[++i];
+        else if (arg == "--rate-hz" && i + 1 < argc) rate_hz = std::stod(argv[++i]);
+        else if (arg == "--deadline-ms" && i + 1 < argc) deadline_ms = std::stod(argv[++i]);
+        else if (arg == "--no-degrade") degrade = false;
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    try {
+        const auto frame = tools::load_bin(frame_path);
+        PFN_CPU pfn;
+        pfn.pfn_weights = tools::load_bin(pfn_weight);
+        pfn.pfn_bias = tools::load_bin(pfn_bias);
+        
+        EnginePoolConfig pool_config;
+        pool_config.num_instances = num_instances;
+        pool_config.deadline_ms = deadline_ms;
+        pool_config.allow_degrade = degrade;
+        pool_config.drop_when_full = rate_hz > 0;
+        for (int i = 0; i < num_instances; ++i) {
+            if (cpus_per_instance > 0) {
+                std::vector<int> cpus;
+                for (int c = 0; c < cpus_per_instance; ++c) cpus.push_back(i * cpus_per_instance + c);
+                pool_config.instance_cpus.push_back(cpus);
+            }
+            if (numa) pool_config.instance_numa_nodes.push_back(i);
+        }
+        
+        EnginePool pool(pool_config, [&](int) {
+            PipelineConfig config;
+            CpuRPNConfig rpn_config;
+            rpn_config.max_batch = 1;
+            rpn_config.simulated_latency_ms = rpn_latency_ms;
+            return std::make_unique<Pipeline>(config, pfn, std::make_unique<CpuRPN>(rpn_config));
+        });
+        
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> sensors;
+        for (int s = 0; s < num_sensors; ++s) {
+            sensors.emplace_back([&, s]() {
+                std::vector<std::future<std::vector<Box3D>>> pending;
+                auto next = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames_per_sensor; ++f) {
+                    if (rate_hz > 0) {
+                        std::this_thread::sleep_until(next);
+                        next += std::chrono::microseconds(static_cast<int64_t>(1e6 / rate_hz));
+                    }
+                    pending.push_back(pool.submit(s, frame));
+                }
+                // 过期/队列满的帧会抛异常，这里只关心统计
+                for (auto& p : pending) {
+                    try {
+                        p.get();
+                    } catch (const std::exception&) {
+                    }
+                }
+            });
+        }
+        for (auto& t : sensors) t.join();
+        const double wall_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "inst  frames   fps      util   mean_lat  max_lat  max_queue  degraded  expired  late  miss_rate\n";
+        uint64_t total = 0;
+        for (const auto& s : pool.stats()) {
+            std::cout << std::setw(4) << s.instance
+                      << std::setw(8) << s.frames
+                      << std::setw(8) << s.fps
+                      << std::setw(8) << s.utilization
+                      << std::setw(10) << s.mean_latency_ms
+                      << std::setw(9) << s.max_latency_ms
+                      << std::setw(10) << s.max_queue_depth
+                      << std::setw(10) << s.degraded
+                      << std::setw(9) << s.expired
+                      << std::setw(6) << s.deadline_missed
+                      << std::setw(11) << s.miss_rate << "\n";
+            total += s.frames;
+        }
+        std::cout << "总计: " << total << " 帧, " << wall_ms << " ms, "
+                  << 1000.0 * total / wall_ms << " frames/s" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,376 @@
+// 传感器帧率回放压测：S 个传感器按固定帧率（可加抖动 / 突发）把一个目录的帧循环送进引擎池，
+// 测持续吞吐、端到端延迟分位数、队列增长和丢帧，结果对应 SLO 里的“持续 10 / 20 Hz”指标
+//
+// 用法: bench_replay [--data-dir <dir> | --frame <bin>] [--sensors S] [--rate-hz R]
+//                    [--duration-s D] [--warmup N] [--jitter-ms J] [--burst B]
+//                    [--instances N] [--queue N] [--block] [--deadline-ms D] [--no-degrade]
+//                    [--backend cpu|mock] [--rpn-latency-ms X] [--pfn-weight p] [--pfn-bias p]
+//                    [--json <path>]
+//
+// 时间模型：第 s 个传感器的第 k 帧采集时刻 = start + (s / S + k) * period + U(-J, J)；
+// --burst B 时驱动攒够 B 帧才一起交出（平均帧率不变）。延迟 = 完成时刻 - 采集时刻，
+// 包含突发等待、排队和处理。每个传感器先送 --warmup 帧预热，全部返回后再开始计时阶段，
+// 提交数、丢帧 / 过期 / 降级等计数和吞吐都只统计计时阶段的帧。
+// 默认队列满时丢帧（传感器不会等待）；--block 时 submit 阻塞，积压体现在延迟里。
+// --backend mock 不做 RPN 计算，只 sleep --rpn-latency-ms，用来单独看 CPU 各阶段能撑住的帧率
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cpu_rpn.h"
+#include "engine_pool.h"
+#include "tool_common.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_between(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// 模拟 NPU：不计算，只 sleep。输出写成常数（score 为很低的 logit，不出框）；
+// Pipeline 复用同一块输出缓冲区，所以只在第一次见到该缓冲区时填写
+class MockRPN : public RPNBackend {
+public:
+    explicit MockRPN(const CpuRPNConfig& config) : config_(config) {}
+
+    void run(const float*, float* box_map, float* score_map, int batch_size) override {
+        if (box_map != filled_box_ || score_map != filled_score_) {
+            const size_t plane = static_cast<size_t>(config_.grid_h) * config_.grid_w;
+            std::fill_n(box_map, plane * config_.box_channels * config_.max_batch, 0.0f);
+            std::fill_n(score_map, plane * config_.score_channels * config_.max_batch, -10.0f);
+            filled_box_ = box_map;
+            filled_score_ = score_map;
+        }
+        (void)batch_size;
+        if (config_.simulated_latency_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(config_.simulated_latency_ms));
+        }
+    }
+
+    void run_sparse(const SparsePillars& pillars, float* box_map, float* score_map) override {
+        run(nullptr, box_map, score_map, pillars.batch_size);
+    }
+
+    int max_batch() const override { return config_.max_batch; }
+
+private:
+    CpuRPNConfig config_;
+    const float* filled_box_ = nullptr;
+    const float* filled_score_ = nullptr;
+};
+
+struct Pending {
+    std::future<std::vector<Box3D>> result;
+    Clock::time_point captured;
+    bool measured;
+};
+
+// 每个传感器一个收集线程：按提交顺序等待结果（同一传感器的帧按序完成），一完成就记时间
+struct SensorLog {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Pending> pending;
+    bool done = false;
+
+    std::vector<double> latencies;         // 计入统计的成功帧
+    Clock::time_point last_submit;         // 最后一次 submit 返回的时刻
+    uint64_t completed = 0;
+    uint64_t errors = 0;                   // 丢帧 / 过期 / 处理失败（详细分类见引擎池统计）
+    uint64_t submitted = 0;
+};
+
+void collect(SensorLog& log) {
+    for (;;) {
+        Pending p;
+        {
+            std::unique_lock<std::mutex> lock(log.mutex);
+            log.cv.wait(lock, [&] { return log.done || !log.pending.empty(); });
+            if (log.pending.empty()) return;
+            p = std::move(log.pending.front());
+            log.pending.pop_front();
+        }
+        bool ok = true;
+        try {
+            p.result.get();
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        const auto now = Clock::now();
+        if (!p.measured) continue;
+        if (!ok) {
+            ++log.errors;
+            continue;
+        }
+        ++log.completed;
+        log.latencies.push_back(ms_between(p.captured, now));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string data_dir;
+    std::string frame_path = "test/kitti_000008.bin";
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    std::string backend = "cpu";
+    std::string json_path;
+    int num_sensors = 1;
+    double rate_hz = 10.0;
+    double duration_s = 10.0;
+    int warmup = 5;
+    double jitter_ms = 0.0;
+    int burst = 1;
+    int num_instances = 1;
+    size_t queue_capacity = 8;
+    bool block = false;
+    double deadline_ms = 0.0;
+    bool degrade = true;
+    double rpn_latency_ms = 0.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--data-dir" && i + 1 < argc) data_dir = argv[++i];
+        else if (arg == "--frame" && i + 1 < argc) frame_path = argv[++i];
+        else if (arg == "--sensors" && i + 1 < argc) num_sensors = std::stoi(argv[++i]);
+        else if (arg == "--rate-hz" && i + 1 < argc) rate_hz = std::stod(argv[++i]);
+        else if (arg == "--duration-s" && i + 1 < argc) duration_s = std::stod(argv[++i]);
+        else if (arg == "--warmup" && i + 1 < argc) warmup = std::stoi(argv[++i]);
+        else if (arg == "--jitter-ms" && i + 1 < argc) jitter_ms = std::stod(argv[++i]);
+        else if (arg == "--burst" && i + 1 < argc) burst = std::stoi(argv[++i]);
+        else if (arg == "--instances" && i + 1 < argc) num_instances = std::stoi(argv[++i]);
+        else if (arg == "--queue" && i + 1 < argc) queue_capacity = std::stoul(argv[++i]);
+        else if (arg == "--block") block = true;
+        else if (arg == "--deadline-ms" && i + 1 < argc) deadline_ms = std::stod(argv[++i]);
+        else if (arg == "--no-degrade") degrade = false;
+        else if (arg == "--backend" && i + 1 < argc) backend = argv[++i];
+        else if (arg == "--rpn-latency-ms" && i + 1 < argc) rpn_latency_ms = std::stod(argv[++i]);
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else if (arg == "--json" && i + 1 < argc) json_path = argv[++i];
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (num_sensors < 1 || rate_hz <= 0 || duration_s * rate_hz < 0.5 || burst < 1 || warmup < 0 || jitter_ms < 0) {
+        std::cerr << "参数超出范围" << std::endl;
+        return 1;
+    }
+    if (backend != "cpu" && backend != "mock") {
+        std::cerr << "未知的 --backend: " << backend << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<std::vector<float>> frames;
+        if (!data_dir.empty()) {
+            for (const auto& f : tools::list_bin_files(data_dir)) frames.push_back(tools::load_bin(f));
+            if (frames.empty()) throw std::runtime_error("目录下没有 .bin 文件: " + data_dir);
+        } else {
+            frames.push_back(tools::load_bin(frame_path));
+        }
+
+        PFN_CPU pfn;
+        pfn.pfn_weights = tools::load_bin(pfn_weight);
+        pfn.pfn_bias = tools::load_bin(pfn_bias);
+
+        EnginePoolConfig pool_config;
+        pool_config.num_instances = num_instances;
+        pool_config.queue_capacity = queue_capacity;
+        pool_config.drop_when_full = !block;
+        pool_config.deadline_ms = deadline_ms;
+        pool_config.allow_degrade = degrade;
+
+        EnginePool pool(pool_config, [&](int) {
+            PipelineConfig config;
+            CpuRPNConfig rpn_config;
+            rpn_config.max_batch = 1;
+            rpn_config.simulated_latency_ms = static_cast<float>(rpn_latency_ms);
+            std::unique_ptr<RPNBackend> rpn;
+            if (backend == "mock") rpn = std::make_unique<MockRPN>(rpn_config);
+            else rpn = std::make_unique<CpuRPN>(rpn_config);
+            return std::make_unique<Pipeline>(config, pfn, std::move(rpn));
+        });
+
+        const int measured_per_sensor = static_cast<int>(duration_s * rate_hz + 0.5);
+        const auto period = std::chrono::duration<double>(1.0 / rate_hz);
+
+        std::cout << "传感器 " << num_sensors << " x " << rate_hz << " Hz, 抖动 ±" << jitter_ms
+                  << " ms, 突发 " << burst << " 帧, 实例 " << num_instances << ", 后端 " << backend
+                  << ", 每个传感器 " << measured_per_sensor << " 帧 (另加预热 " << warmup << ")" << std::endl;
+
+        // 一个阶段：每个传感器从第 first 帧起按时间表提交 count 帧，返回前等到所有结果。
+        // depth_samples 不为空时顺带采样队列深度（所有实例之和）。返回时间表起点
+        auto run_phase = [&](int first, int count, bool measured,
+                             std::vector<std::unique_ptr<SensorLog>>& logs,
+                             std::vector<std::pair<double, double>>* depth_samples) {
+            logs.clear();
+            for (int s = 0; s < num_sensors; ++s) logs.push_back(std::make_unique<SensorLog>());
+            const auto start = Clock::now() + std::chrono::milliseconds(50);
+            std::vector<std::thread> collectors, sensors;
+            for (int s = 0; s < num_sensors; ++s) {
+                collectors.emplace_back(collect, std::ref(*logs[s]));
+                sensors.emplace_back([&, s]() {
+                    SensorLog& log = *logs[s];
+                    std::mt19937 rng(1234 + s + first);
+                    std::uniform_real_distribution<double> jitter(-jitter_ms, jitter_ms);
+                    // 采集时刻单调：抖动后不早于上一帧
+                    std::vector<Clock::time_point> captured(burst);
+                    Clock::time_point last = start;
+                    for (int g = 0; g < count; g += burst) {
+                        const int n = std::min(burst, count - g);
+                        for (int j = 0; j < n; ++j) {
+                            const double phase = static_cast<double>(s) / num_sensors + g + j;
+                            auto t = start + std::chrono::duration_cast<Clock::duration>(
+                                period * phase + std::chrono::duration<double, std::milli>(jitter(rng)));
+                            captured[j] = last = std::max(t, last);
+                        }
+                        std::this_thread::sleep_until(captured[n - 1]);
+                        for (int j = 0; j < n; ++j) {
+                            const int k = first + g + j;
+                            Pending p;
+                            p.result = pool.submit(s, frames[(static_cast<size_t>(k) * num_sensors + s) % frames.size()]);
+                            p.captured = captured[j];
+                            p.measured = measured;
+                            std::lock_guard<std::mutex> lock(log.mutex);
+                            log.submitted += p.measured;
+                            log.last_submit = Clock::now();
+                            log.pending.push_back(std::move(p));
+                            log.cv.notify_one();
+                        }
+                    }
+                    std::lock_guard<std::mutex> lock(log.mutex);
+                    log.done = true;
+                    log.cv.notify_one();
+                });
+            }
+
+            bool running = true;
+            while (running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                running = false;
+                for (const auto& log : logs) {
+                    std::lock_guard<std::mutex> lock(log->mutex);
+                    running = running || !log->done;
+                }
+                const auto now = Clock::now();
+                if (!depth_samples || now < start) continue;
+                size_t depth = 0;
+                for (const auto& st : pool.stats()) depth += st.queue_depth;
+                depth_samples->emplace_back(ms_between(start, now) / 1000.0, static_cast<double>(depth));
+            }
+            for (auto& t : sensors) t.join();
+            for (auto& t : collectors) t.join();
+            return start;
+        };
+
+        // 预热单独一个阶段并等全部结果返回后再取统计快照：此后池的各项计数只来自计时阶段的帧
+        std::vector<std::unique_ptr<SensorLog>> logs;
+        if (warmup > 0) run_phase(0, warmup, false, logs, nullptr);
+        const auto baseline = pool.stats();
+
+        // 队列深度采样，用最小二乘斜率表示增长速度
+        std::vector<std::pair<double, double>> depth_samples;
+        const auto start = run_phase(warmup, measured_per_sensor, true, logs, &depth_samples);
+
+        std::vector<double> latencies;
+        uint64_t submitted = 0, completed = 0, errors = 0;
+        auto last_submit = start;
+        for (const auto& log : logs) {
+            latencies.insert(latencies.end(), log->latencies.begin(), log->latencies.end());
+            submitted += log->submitted;
+            completed += log->completed;
+            errors += log->errors;
+            last_submit = std::max(last_submit, log->last_submit);
+        }
+        // 计时阶段的计数 = 当前统计 - 预热结束时的快照
+        uint64_t dropped = 0, expired = 0, failed = 0, degraded = 0, missed = 0;
+        size_t max_depth = 0;
+        const auto final_stats = pool.stats();
+        for (size_t i = 0; i < final_stats.size(); ++i) {
+            const auto& st = final_stats[i];
+            const auto& base = baseline[i];
+            dropped += st.dropped - base.dropped;
+            expired += st.expired - base.expired;
+            failed += st.failed - base.failed;
+            degraded += st.degraded - base.degraded;
+            missed += st.deadline_missed - base.deadline_missed;
+            max_depth = std::max(max_depth, st.max_queue_depth);
+        }
+
+        double depth_mean = 0, slope = 0;
+        if (!depth_samples.empty()) {
+            double st = 0, sd = 0;
+            for (const auto& [t, d] : depth_samples) {
+                st += t;
+                sd += d;
+            }
+            const double n = static_cast<double>(depth_samples.size());
+            const double mt = st / n;
+            depth_mean = sd / n;
+            double num = 0, den = 0;
+            for (const auto& [t, d] : depth_samples) {
+                num += (t - mt) * (d - depth_mean);
+                den += (t - mt) * (t - mt);
+            }
+            slope = den > 0 ? num / den : 0;
+        }
+
+        // 吞吐窗口 = 输入窗口：每个传感器 M 帧占 M 个周期（第一帧采集到最后一帧采集再加一个周期）。
+        // --block 且处理跟不上时传感器线程落后于时间表，窗口延长到最后一次 submit 返回
+        const double offered_window_s = measured_per_sensor * period.count();
+        const double window_s = std::max(offered_window_s, ms_between(start, last_submit) / 1000.0);
+        const double sustained = completed / window_s;
+        const double offered = num_sensors * rate_hz;
+        const double p50 = tools::percentile(latencies, 50);
+        const double p90 = tools::percentile(latencies, 90);
+        const double p99 = tools::percentile(latencies, 99);
+        const double p999 = tools::percentile(latencies, 99.9);
+        const double max_lat = latencies.empty() ? 0.0 : latencies.back();  // percentile 已排序
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "提交 " << submitted << " 帧, 完成 " << completed << ", 失败 " << errors
+                  << " (队列满丢帧 " << dropped << ", 过期 " << expired << ", 处理出错 " << failed << ")"
+                  << ", 降级 " << degraded << ", 超时完成 " << missed << "\n"
+                  << "吞吐: 输入 " << offered << " 帧/s, 持续 " << sustained << " 帧/s\n"
+                  << "延迟 (ms): p50 " << p50 << "  p90 " << p90 << "  p99 " << p99
+                  << "  p99.9 " << p999 << "  max " << max_lat << "\n"
+                  << "队列深度: 平均 " << depth_mean << ", 最大 " << max_depth
+                  << ", 增长 " << slope << " 帧/s" << std::endl;
+
+        if (!json_path.empty()) {
+            std::ofstream out(json_path);
+            if (!out) throw std::runtime_error("无法写入: " + json_path);
+            out << std::fixed << std::setprecision(3)
+                << "{\"sensors\": " << num_sensors << ", \"rate_hz\": " << rate_hz
+                << ", \"jitter_ms\": " << jitter_ms << ", \"burst\": " << burst
+                << ", \"instances\": " << num_instances << ", \"backend\": \"" << backend << "\""
+                << ", \"submitted\": " << submitted << ", \"completed\": " << completed
+                << ", \"dropped\": " << dropped << ", \"expired\": " << expired << ", \"failed\": " << failed
+                << ", \"degraded\": " << degraded << ", \"deadline_missed\": " << missed
+                << ", \"offered_fps\": " << offered << ", \"sustained_fps\": " << sustained
+                << ", \"latency_ms\": {\"p50\": " << p50 << ", \"p90\": " << p90 << ", \"p99\": " << p99
+                << ", \"p99_9\": " << p999 << ", \"max\": " << max_lat << "}"
+                << ", \"queue\": {\"mean\": " << depth_mean << ", \"max\": " << max_depth
+                << ", \"growth_per_s\": " << slope << "}}\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
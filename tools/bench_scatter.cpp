@@ -0,0 +1,103 @@
+// scatter 带宽基准：同一帧分别按 Arrival / RowMajor / Morton 顺序输出 pillar，
+// 对比体素化耗时和 scatter_sparse_to_dense 写 [1, 64, 496, 432] BEV map 的带宽
+//
+// 用法: bench_scatter [--frame <bin>] [--iters N] [--pfn-weight p] [--pfn-bias p]
+//
+// scatter 按 rpn_backend 的方式进行：只清零上一帧写过的 cell 再写入新特征，
+// 带宽按写入的特征字节数 (P * C * 4) 计
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "pfn.hpp"
+#include "tool_common.h"
+#include "voxelizer.h"
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string frame_path = "test/kitti_000008.bin";
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    int iters = 50;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frame" && i + 1 < argc) frame_path = argv[++i];
+        else if (arg == "--iters" && i + 1 < argc) iters = std::stoi(argv[++i]);
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        const auto frame = tools::load_bin(frame_path);
+        PFN_CPU pfn;
+        pfn.pfn_weights = tools::load_bin(pfn_weight);
+        pfn.pfn_bias = tools::load_bin(pfn_bias);
+
+        const std::vector<std::pair<const char*, PillarOrder>> orders = {
+            {"arrival", PillarOrder::Arrival},
+            {"row", PillarOrder::RowMajor},
+            {"morton", PillarOrder::Morton},
+        };
+
+        std::vector<float> bev(static_cast<size_t>(pfn.grid_h) * pfn.grid_w * 64, 0.0f);
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "order    pillars  voxel_ms  scatter_ms  GB/s\n";
+        for (const auto& [name, order] : orders) {
+            VoxelConfig config;
+            config.verbose = false;
+            config.order = order;
+            pfn.voxel = config;
+            Voxelizer voxelizer(config);
+
+            auto t0 = std::chrono::steady_clock::now();
+            VoxelData voxel_data;
+            for (int it = 0; it < iters; ++it) {
+                voxel_data = voxelizer.generate(frame);
+            }
+            const double voxel_ms = elapsed_ms(t0) / iters;
+
+            SparsePillars pillars;
+            pfn.run_sparse(make_voxel_info(voxel_data, config), pillars);
+            if (bev.size() != static_cast<size_t>(pillars.grid_h) * pillars.grid_w * pillars.channels) {
+                bev.assign(static_cast<size_t>(pillars.grid_h) * pillars.grid_w * pillars.channels, 0.0f);
+            }
+
+            // 预热一次，之后每次只清零上一次写过的 cell
+            std::fill(bev.begin(), bev.end(), 0.0f);
+            scatter_sparse_to_dense(pillars, bev.data());
+            t0 = std::chrono::steady_clock::now();
+            for (int it = 0; it < iters; ++it) {
+                scatter_sparse_to_dense(pillars, bev.data(), &pillars.cell_indices);
+            }
+            const double scatter_ms = elapsed_ms(t0) / iters;
+            const double bytes = static_cast<double>(pillars.features.size()) * sizeof(float);
+
+            std::cout << std::left << std::setw(9) << name << std::right
+                      << std::setw(7) << pillars.num_pillars
+                      << std::setw(10) << voxel_ms
+                      << std::setw(12) << scatter_ms
+                      << std::setw(8) << bytes / (scatter_ms * 1e6) << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// 模型打包工具：把 PFN 权重 / 偏置（可选 BN 折叠）、预设的体素与 decode 配置和 RPN 模型路径
+// 写成一个模型包（见 model_bundle.h），写完后重新打开校验
+//
+// 用法: pack_bundle -o <out> [--preset kitti|nuscenes] [--pfn-weight p] [--pfn-bias p]
+//                   [--pfn-bn prefix] [--rpn-model path]
+//
+// --rpn-model 按原样写入；相对路径在加载时按模型包所在目录解析
+
+#include <iostream>
+#include <string>
+
+#include "model_bundle.h"
+#include "pillar_config.h"
+#include "tool_common.h"
+
+int main(int argc, char** argv) {
+    std::string out_path;
+    std::string preset = "kitti";
+    std::string pfn_weight = "pfn_weight.bin";
+    std::string pfn_bias = "pfn_bias.bin";
+    std::string pfn_bn;
+    std::string rpn_model;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--preset" && i + 1 < argc) preset = argv[++i];
+        else if (arg == "--pfn-weight" && i + 1 < argc) pfn_weight = argv[++i];
+        else if (arg == "--pfn-bias" && i + 1 < argc) pfn_bias = argv[++i];
+        else if (arg == "--pfn-bn" && i + 1 < argc) pfn_bn = argv[++i];
+        else if (arg == "--rpn-model" && i + 1 < argc) rpn_model = argv[++i];
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (out_path.empty()) {
+        std::cerr << "需要 -o <out>" << std::endl;
+        return 1;
+    }
+
+    try {
+        ModelBundleContents contents;
+        if (preset == "kitti") {
+            contents.voxel = make_voxel_config<KittiPillars>();
+            contents.decode = make_decode_config<KittiPillars>();
+        } else if (preset == "nuscenes") {
+            contents.voxel = make_voxel_config<NuScenesPillars>();
+            contents.decode = make_decode_config<NuScenesPillars>();
+        } else {
+            std::cerr << "未知的 --preset: " << preset << std::endl;
+            return 1;
+        }
+        contents.rpn_model_path = rpn_model;
+
+        PFN_CPU pfn;
+        pfn.pfn_weights = tools::load_bin(pfn_weight);
+        pfn.pfn_bias = tools::load_bin(pfn_bias);
+        if (!pfn_bn.empty()) {
+            pfn.fold_batchnorm(tools::load_bin(pfn_bn + "_gamma.bin"), tools::load_bin(pfn_bn + "_beta.bin"),
+                               tools::load_bin(pfn_bn + "_mean.bin"), tools::load_bin(pfn_bn + "_var.bin"));
+        }
+        contents.pfn = pfn.packed_weights(contents.voxel.num_point_features);
+        write_model_bundle(out_path, contents);
+
+        ModelBundle bundle(out_path);
+        const auto w = bundle.pfn_weights();
+        const auto dc = bundle.decode_config();
+        std::cout << "已写入 " << out_path << " (v" << bundle.version() << ")\n"
+                  << "  PFN: [" << w.num_features << ", " << w.channels << "], center_dims "
+                  << w.center_dims << (w.relu ? ", ReLU" : "") << "\n"
+                  << "  grid: " << dc.grid_x << " x " << dc.grid_y << ", anchors "
+                  << dc.anchor_sizes.size() << " x " << dc.num_rot << ", classes " << dc.num_classes << "\n"
+                  << "  RPN: " << (rpn_model.empty() ? "(无)" : bundle.rpn_model_path()) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
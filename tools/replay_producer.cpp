@@ -0,0 +1,123 @@
+// 推理服务的测试生产者：把 .bin 点云按顺序发给服务端，校验响应并统计往返延迟，
+// 结束时请求服务端的统计信息
+//
+// 用法: replay_producer [--socket <path>] [--data-dir <dir> | --frame <bin>]
+//                       [--frames N] [--sensor-id id] [--inflight N]
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "server_protocol.h"
+#include "tool_common.h"
+
+using pp_server::MessageHeader;
+using pp_server::MessageType;
+
+int main(int argc, char** argv) {
+    std::string socket_path = "/tmp/pointpillars.sock";
+    std::string data_dir;
+    std::string frame_path = "test/kitti_000008.bin";
+    int num_frames = 0;       // 0 = 目录下全部文件（单文件时默认 10 次）
+    uint32_t sensor_id = 0;
+    size_t inflight = 1;      // 同一连接上未收到响应的帧数上限
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socket_path = argv[++i];
+        else if (arg == "--data-dir" && i + 1 < argc) data_dir = argv[++i];
+        else if (arg == "--frame" && i + 1 < argc) frame_path = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc) num_frames = std::stoi(argv[++i]);
+        else if (arg == "--sensor-id" && i + 1 < argc) sensor_id = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--inflight" && i + 1 < argc) inflight = std::max(1, std::stoi(argv[++i]));
+        else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    try {
+        std::vector<std::string> files;
+        if (!data_dir.empty()) {
+            files = tools::list_bin_files(data_dir);
+            if (files.empty()) throw std::runtime_error("目录下没有 .bin 文件: " + data_dir);
+            if (num_frames <= 0) num_frames = static_cast<int>(files.size());
+        } else {
+            files.push_back(frame_path);
+            if (num_frames <= 0) num_frames = 10;
+        }
+        
+        int fd = pp_server::connect_unix(socket_path);
+        
+        using Clock = std::chrono::steady_clock;
+        std::deque<Clock::time_point> sent;
+        std::vector<double> latencies;
+        int errors = 0;
+        uint32_t next_expected = 0;
+        MessageHeader reply;
+        std::vector<char> payload;
+        
+        auto receive_one = [&]() {
+            if (!pp_server::read_message(fd, reply, payload)) {
+                throw std::runtime_error("服务端关闭了连接");
+            }
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - sent.front()).count();
+            sent.pop_front();
+            if (reply.frame_id != next_expected) {
+                throw std::runtime_error("响应乱序: 期望 " + std::to_string(next_expected) +
+                                         ", 收到 " + std::to_string(reply.frame_id));
+            }
+            ++next_expected;
+            if (reply.type == static_cast<uint16_t>(MessageType::Detections)) {
+                auto boxes = pp_server::from_records(payload.data(), reply.num_items);
+                latencies.push_back(ms);
+                std::cout << "帧 " << reply.frame_id << ": " << boxes.size() << " 个框, "
+                          << std::fixed << std::setprecision(2) << ms << " ms" << std::endl;
+            } else {
+                ++errors;
+                std::cerr << "帧 " << reply.frame_id << " 出错: "
+                          << std::string(payload.begin(), payload.end()) << std::endl;
+            }
+        };
+        
+        for (int f = 0; f < num_frames; ++f) {
+            auto points = tools::load_bin(files[f % files.size()]);
+            MessageHeader h;
+            h.type = static_cast<uint16_t>(MessageType::Frame);
+            h.sensor_id = sensor_id;
+            h.frame_id = static_cast<uint32_t>(f);
+            h.num_features = 4;
+            h.num_items = static_cast<uint32_t>(points.size() / 4);
+            h.payload_bytes = h.num_items * 4 * sizeof(float);
+            
+            if (sent.size() >= inflight) receive_one();
+            sent.push_back(Clock::now());
+            pp_server::write_message(fd, h, points.data());
+        }
+        while (!sent.empty()) receive_one();
+        
+        // 服务端统计
+        MessageHeader stats;
+        stats.type = static_cast<uint16_t>(MessageType::Stats);
+        pp_server::write_message(fd, stats, nullptr);
+        if (pp_server::read_message(fd, reply, payload)) {
+            std::cout << "服务端统计: " << std::string(payload.begin(), payload.end()) << std::endl;
+        }
+        ::close(fd);
+        
+        std::cout << std::fixed << std::setprecision(2)
+                  << "完成 " << latencies.size() << " 帧, 错误 " << errors
+                  << ", 往返延迟 p50=" << tools::percentile(latencies, 50)
+                  << " p99=" << tools::percentile(latencies, 99) << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}